@@ -0,0 +1,190 @@
+#include "arena.h"
+#include "pinned.h"
+
+#include <algorithm>
+#include <iomanip>
+#include <memory>
+#include <new>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace {
+
+    const size_t HUGE_PAGE_BYTES = 2 << 20;
+    // Chunks are at least this large so many vectors share their huge pages.
+    const size_t CHUNK_BYTES = 256 << 20;
+    const size_t CACHE_LINE_BYTES = 64;
+    const size_t PAGE_BYTES = 4096;
+    // From linux/mempolicy.h, which the libc headers do not include.
+    const int MPOL_PREFERRED = 1;
+
+    HostMemory selectedMemory = HostMemory::Default;
+    bool arenaNumaLocal = true;
+    std::mutex arenaMutex;
+    std::unique_ptr<HugePageArena> arena;
+
+    size_t roundUp(size_t bytes, size_t multiple) {
+        return (std::max<size_t>(bytes, 1) + multiple - 1) / multiple * multiple;
+    }
+
+    HugePageArena &sharedArena() {
+        std::lock_guard lock(arenaMutex);
+        if (!arena) {
+            arena = std::make_unique<HugePageArena>(arenaNumaLocal);
+        }
+        return *arena;
+    }
+
+    // Prefers the node of the CPU running the caller for pages of [data, data + bytes) not touched yet.
+    void preferLocalNode(void *data, size_t bytes) {
+        unsigned cpu, node;
+        if (getcpu(&cpu, &node) != 0) {
+            return;
+        }
+        unsigned long nodeMask[16] = {};
+        if (node >= sizeof(nodeMask) * 8) {
+            return;
+        }
+        nodeMask[node / (sizeof(unsigned long) * 8)] = 1ul << (node % (sizeof(unsigned long) * 8));
+        // Placement is a hint, failing on systems without NUMA support is fine.
+        syscall(SYS_mbind, data, bytes, MPOL_PREFERRED, nodeMask, sizeof(nodeMask) * 8, 0);
+    }
+}
+
+HugePageArena::HugePageArena(bool numaLocal) : numaLocal(numaLocal) {
+}
+
+HugePageArena::~HugePageArena() {
+    for (const auto &chunk: chunks) {
+        munmap(chunk.data, chunk.bytes);
+    }
+}
+
+void *HugePageArena::allocate(size_t bytes) {
+    const size_t alignment = bytes >= PAGE_BYTES ? PAGE_BYTES : CACHE_LINE_BYTES;
+    bytes = roundUp(bytes, CACHE_LINE_BYTES);
+
+    std::lock_guard lock(mutex);
+    size_t offset;
+    for (auto &chunk: chunks) {
+        if (chunk.free.take(bytes, alignment, offset)) {
+            used += bytes;
+            return chunk.data + offset;
+        }
+    }
+    if (!mapChunk(std::max(roundUp(bytes, HUGE_PAGE_BYTES), CHUNK_BYTES))) {
+        throw std::bad_alloc();
+    }
+    chunks.back().free.take(bytes, alignment, offset);
+    used += bytes;
+    return chunks.back().data + offset;
+}
+
+void HugePageArena::deallocate(void *pointer, size_t bytes) {
+    bytes = roundUp(bytes, CACHE_LINE_BYTES);
+    auto *data = static_cast<char *>(pointer);
+
+    std::lock_guard lock(mutex);
+    for (auto &chunk: chunks) {
+        if (data >= chunk.data && data < chunk.data + chunk.bytes) {
+            chunk.free.give(data - chunk.data, bytes);
+            used -= bytes;
+            return;
+        }
+    }
+}
+
+bool HugePageArena::mapChunk(size_t bytes) {
+    bool hugeTlb = true;
+    void *data = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    if (data == MAP_FAILED) {
+        // No huge pages reserved: map one huge page more and trim it to a huge page boundary, so that
+        // transparent huge pages can back the whole chunk.
+        hugeTlb = false;
+        void *mapped = mmap(nullptr, bytes + HUGE_PAGE_BYTES, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS,
+                            -1, 0);
+        if (mapped == MAP_FAILED) {
+            return false;
+        }
+        auto *begin = static_cast<char *>(mapped);
+        auto *aligned = reinterpret_cast<char *>(roundUp(reinterpret_cast<uintptr_t>(begin), HUGE_PAGE_BYTES));
+        if (aligned > begin) {
+            munmap(begin, aligned - begin);
+        }
+        munmap(aligned + bytes, begin + bytes + HUGE_PAGE_BYTES - aligned - bytes);
+        madvise(aligned, bytes, MADV_HUGEPAGE);
+        data = aligned;
+    }
+    if (numaLocal) {
+        preferLocalNode(data, bytes);
+    }
+    chunks.push_back({static_cast<char *>(data), bytes, hugeTlb, FreeBlocks(bytes)});
+    return true;
+}
+
+void HugePageArena::printStats(std::ostream &out) const {
+    std::lock_guard lock(mutex);
+    size_t hugeTlbBytes = 0, transparentBytes = 0;
+    for (const auto &chunk: chunks) {
+        (chunk.hugeTlb ? hugeTlbBytes : transparentBytes) += chunk.bytes;
+    }
+    out << "Huge page arena: " << (hugeTlbBytes >> 20) << " MB in explicit huge pages, " << (transparentBytes >> 20)
+        << " MB in transparent huge pages, " << (used >> 20) << " MB in use"
+        << (numaLocal ? ", NUMA local" : "") << "\n";
+}
+
+std::string hostMemoryName(HostMemory memory) {
+    switch (memory) {
+        case HostMemory::Default:
+            return "default";
+        case HostMemory::Pinned:
+            return "pinned";
+        case HostMemory::HugePages:
+            return "huge-pages";
+    }
+    return "";
+}
+
+void setHostMemory(HostMemory memory, bool numaLocal) {
+    std::lock_guard lock(arenaMutex);
+    selectedMemory = memory;
+    arenaNumaLocal = numaLocal;
+}
+
+HostMemory hostMemory() {
+    std::lock_guard lock(arenaMutex);
+    return selectedMemory;
+}
+
+void *allocateHost(HostMemory memory, size_t bytes) {
+    switch (memory) {
+        case HostMemory::Pinned:
+            return PinnedMemory::allocate(bytes);
+        case HostMemory::HugePages:
+            return sharedArena().allocate(bytes);
+        default:
+            return ::operator new(bytes);
+    }
+}
+
+void deallocateHost(HostMemory memory, void *pointer, size_t bytes) {
+    switch (memory) {
+        case HostMemory::Pinned:
+            PinnedMemory::deallocate(pointer, bytes);
+            break;
+        case HostMemory::HugePages:
+            sharedArena().deallocate(pointer, bytes);
+            break;
+        default:
+            ::operator delete(pointer);
+    }
+}
+
+void printHostMemoryStats(std::ostream &out) {
+    std::lock_guard lock(arenaMutex);
+    if (arena) {
+        arena->printStats(out);
+    }
+}
@@ -0,0 +1,99 @@
+#pragma once
+
+#include "blocks.h"
+
+#include <cstddef>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+/**
+ * Host memory from chunks backed by 2 MB pages: explicit huge pages (MAP_HUGETLB) when the
+ * system has some reserved, else transparent huge pages requested with madvise. Blocks are
+ * aligned to a cache line, and to a page from a page up, so drivers can wrap them without
+ * copying. With numaLocal, each chunk prefers the NUMA node of the thread that mapped it.
+ * Chunks are kept for reuse and only unmapped with the arena.
+ **/
+class HugePageArena {
+public:
+    explicit HugePageArena(bool numaLocal);
+
+    ~HugePageArena();
+
+    HugePageArena(const HugePageArena &) = delete;
+
+    HugePageArena &operator=(const HugePageArena &) = delete;
+
+    void *allocate(size_t bytes);
+
+    void deallocate(void *pointer, size_t bytes);
+
+    // Chunk sizes by backing, and the bytes handed out.
+    void printStats(std::ostream &out) const;
+
+private:
+    struct Chunk {
+        char *data;
+        size_t bytes;
+        bool hugeTlb;   // Explicit huge pages, else transparent ones
+        FreeBlocks free;
+    };
+
+    bool mapChunk(size_t bytes);
+
+    bool numaLocal;
+    std::vector<Chunk> chunks;
+    size_t used = 0;
+    mutable std::mutex mutex;
+};
+
+// Where vectors using HostAllocator get their memory.
+enum class HostMemory {
+    Default,    // operator new
+    Pinned,     // PinnedMemory, see pinned.h
+    HugePages   // a HugePageArena shared by the process
+};
+
+std::string hostMemoryName(HostMemory memory);
+
+// Memory HostAllocators created from now on use. The arena is created on first use with numaLocal.
+void setHostMemory(HostMemory memory, bool numaLocal = true);
+
+HostMemory hostMemory();
+
+void *allocateHost(HostMemory memory, size_t bytes);
+
+void deallocateHost(HostMemory memory, void *pointer, size_t bytes);
+
+// Prints the state of the huge page arena, if it was used.
+void printHostMemoryStats(std::ostream &out);
+
+/**
+ * Allocator drawing from the memory selected with setHostMemory when it was created. It keeps
+ * that choice, so vectors free their memory where it came from even if the selection changes.
+ **/
+template<typename T>
+struct HostAllocator {
+    using value_type = T;
+
+    HostMemory memory = hostMemory();
+
+    HostAllocator() = default;
+
+    template<typename U>
+    HostAllocator(const HostAllocator<U> &other) : memory(other.memory) {}
+
+    T *allocate(size_t n) {
+        return static_cast<T *>(allocateHost(memory, sizeof(T) * n));
+    }
+
+    void deallocate(T *pointer, size_t n) {
+        deallocateHost(memory, pointer, sizeof(T) * n);
+    }
+
+    template<typename U>
+    bool operator==(const HostAllocator<U> &other) const {
+        return memory == other.memory;
+    }
+};
@@ -0,0 +1,176 @@
+#include "bandwidth.h"
+#include "program.h"
+
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+
+namespace {
+
+    const std::string STREAM_PROGRAM_FILE = "stream.cl";
+    const std::string VADD_PROGRAM_FILE = "kernel.cl";
+    // STREAM reports the best of several runs to filter out warm-up and scheduling noise.
+    const int REPEATS = 10;
+    const int WIDTHS[] = {1, 2, 4, 8, 16};
+    const float Q = 3.0f;
+
+    struct StreamOperation {
+        std::string name;
+        int arrays;     // Arrays read or written, each moved once per element
+        bool scaled;    // Takes the scalar q as last argument
+    };
+
+    const StreamOperation OPERATIONS[] = {
+            {"copy",  2, false},
+            {"scale", 2, true},
+            {"add",   3, false},
+            {"triad", 3, true},
+    };
+
+    double toGbPerSecond(size_t bytes, double seconds) {
+        return static_cast<double>(bytes) / seconds * 1e-9;
+    }
+
+    // Best kernel execution time of REPEATS launches according to event profiling.
+    double bestKernelSeconds(const cl::CommandQueue &queue, const cl::Kernel &kernel, const cl::NDRange &global) {
+        cl_ulong best = std::numeric_limits<cl_ulong>::max();
+        for (int i = 0; i < REPEATS; i++) {
+            cl::Event event;
+            queue.enqueueNDRangeKernel(kernel, cl::NullRange, global, cl::NullRange, nullptr, &event);
+            event.wait();
+            best = std::min(best, event.getProfilingInfo<CL_PROFILING_COMMAND_END>() -
+                                  event.getProfilingInfo<CL_PROFILING_COMMAND_START>());
+        }
+        return static_cast<double>(best) * 1e-9;
+    }
+
+    template<typename Loop>
+    double bestHostSeconds(Loop loop) {
+        auto best = std::chrono::duration<double>::max();
+        for (int i = 0; i < REPEATS; i++) {
+            auto start_time = std::chrono::high_resolution_clock::now();
+            loop();
+            best = std::min<std::chrono::duration<double>>(best, std::chrono::high_resolution_clock::now() - start_time);
+        }
+        return best.count();
+    }
+
+    double peakOf(const std::vector<BandwidthResult> &results) {
+        double peak = 0;
+        for (const auto &result: results) {
+            peak = std::max(peak, result.gbPerSecond);
+        }
+        return peak;
+    }
+
+    void printResults(const std::vector<BandwidthResult> &results) {
+        std::cout << std::fixed << std::setprecision(1);
+        for (const auto &operation: OPERATIONS) {
+            std::cout << "  " << std::left << std::setw(6) << operation.name << std::right;
+            for (const auto &result: results) {
+                if (result.operation == operation.name) {
+                    std::cout << "  x" << std::setw(2) << std::left << result.width << std::right << std::setw(8)
+                              << result.gbPerSecond;
+                }
+            }
+            std::cout << "\n";
+        }
+    }
+}
+
+std::vector<BandwidthResult> measureDeviceBandwidth(const cl::Context &context, const cl::Device &device,
+                                                    size_t elements) {
+    // Every width must divide the element count, which takes at least one element of the widest kernel.
+    const size_t widest = WIDTHS[std::size(WIDTHS) - 1];
+    elements = std::max(elements - elements % widest, widest);
+    const size_t bytes = sizeof(float) * elements;
+
+    cl::Program program = buildProgram(context, device, STREAM_PROGRAM_FILE);
+    cl::CommandQueue queue(context, device, CL_QUEUE_PROFILING_ENABLE);
+    cl::Buffer aBuf(context, CL_MEM_READ_WRITE, bytes);
+    cl::Buffer bBuf(context, CL_MEM_READ_WRITE, bytes);
+    cl::Buffer cBuf(context, CL_MEM_READ_WRITE, bytes);
+    queue.enqueueFillBuffer(aBuf, 1.0f, 0, bytes);
+    queue.enqueueFillBuffer(bBuf, 2.0f, 0, bytes);
+    queue.enqueueFillBuffer(cBuf, 0.0f, 0, bytes);
+    queue.finish();
+
+    std::vector<BandwidthResult> results;
+    for (const auto &operation: OPERATIONS) {
+        for (int width: WIDTHS) {
+            cl::Kernel kernel(program, (operation.name + "_" + std::to_string(width)).c_str());
+            cl_uint arg = 0;
+            kernel.setArg(arg++, aBuf);
+            if (operation.arrays == 3) {
+                kernel.setArg(arg++, bBuf);
+            }
+            kernel.setArg(arg++, cBuf);
+            if (operation.scaled) {
+                kernel.setArg(arg++, Q);
+            }
+
+            double seconds = bestKernelSeconds(queue, kernel, cl::NDRange(elements / width));
+            results.push_back({operation.name, width, toGbPerSecond(operation.arrays * bytes, seconds)});
+        }
+    }
+    return results;
+}
+
+std::vector<BandwidthResult> measureHostBandwidth(size_t elements) {
+    const size_t bytes = sizeof(float) * elements;
+    std::vector<float> a(elements, 1.0f), b(elements, 2.0f), c(elements, 0.0f);
+
+    std::vector<BandwidthResult> results;
+    auto measure = [&](const StreamOperation &operation, auto body) {
+        double seconds = bestHostSeconds([&] {
+            for (size_t i = 0; i < elements; i++) {
+                body(i);
+            }
+        });
+        results.push_back({operation.name, 1, toGbPerSecond(operation.arrays * bytes, seconds)});
+    };
+    measure(OPERATIONS[0], [&](size_t i) { c[i] = a[i]; });
+    measure(OPERATIONS[1], [&](size_t i) { c[i] = Q * a[i]; });
+    measure(OPERATIONS[2], [&](size_t i) { c[i] = a[i] + b[i]; });
+    measure(OPERATIONS[3], [&](size_t i) { c[i] = a[i] + Q * b[i]; });
+    return results;
+}
+
+double measureVaddBandwidth(const cl::Context &context, const cl::Device &device, size_t elements) {
+    const size_t bytes = sizeof(float) * elements;
+
+    cl::Program program = buildProgram(context, device, VADD_PROGRAM_FILE);
+    cl::CommandQueue queue(context, device, CL_QUEUE_PROFILING_ENABLE);
+    cl::Buffer aBuf(context, CL_MEM_READ_ONLY, bytes);
+    cl::Buffer bBuf(context, CL_MEM_READ_ONLY, bytes);
+    cl::Buffer cBuf(context, CL_MEM_WRITE_ONLY, bytes);
+    queue.enqueueFillBuffer(aBuf, 1.0f, 0, bytes);
+    queue.enqueueFillBuffer(bBuf, 2.0f, 0, bytes);
+    queue.finish();
+
+    cl::Kernel kernel(program, "vadd");
+    kernel.setArg(0, Q);
+    kernel.setArg(1, aBuf);
+    kernel.setArg(2, bBuf);
+    kernel.setArg(3, cBuf);
+    return toGbPerSecond(3 * bytes, bestKernelSeconds(queue, kernel, cl::NDRange(elements)));
+}
+
+void printBandwidthReport(const std::vector<cl::Device> &devices, size_t elements) {
+    std::cout << "Host memory bandwidth (GB/s):\n";
+    printResults(measureHostBandwidth(elements));
+
+    for (const auto &device: devices) {
+        cl::Context context(device);
+        auto results = measureDeviceBandwidth(context, device, elements);
+        double vadd = measureVaddBandwidth(context, device, elements);
+        double peak = peakOf(results);
+
+        std::cout << "Device memory bandwidth of " << device.getInfo<CL_DEVICE_NAME>() << " (GB/s):\n";
+        printResults(results);
+        std::cout << "  vadd   " << vadd << " GB/s, " << 100 * vadd / peak << "% of measured peak " << peak
+                  << " GB/s" << std::endl;
+    }
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <CL/opencl.hpp>
+#include <string>
+#include <vector>
+
+// Sustained bandwidth of one STREAM operation at one vector width.
+struct BandwidthResult {
+    std::string operation;  // copy, scale, add or triad
+    int width;              // floats per work-item, 1 on the host
+    double gbPerSecond;
+};
+
+// Runs the STREAM kernels from stream.cl over buffers of `elements` floats.
+std::vector<BandwidthResult> measureDeviceBandwidth(const cl::Context &context, const cl::Device &device,
+                                                    size_t elements);
+
+// Runs the same operations as plain loops on the host.
+std::vector<BandwidthResult> measureHostBandwidth(size_t elements);
+
+// Bandwidth achieved by the vadd kernel, counting x, y and c once each.
+double measureVaddBandwidth(const cl::Context &context, const cl::Device &device, size_t elements);
+
+/**
+ * Prints the host STREAM results, then for every device its STREAM results and the
+ * bandwidth of vadd as a percentage of the best bandwidth measured on that device.
+ **/
+void printBandwidthReport(const std::vector<cl::Device> &devices, size_t elements);
@@ -0,0 +1,273 @@
+#include "baseline.h"
+#include "json.h"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <numeric>
+#include <sstream>
+
+namespace {
+
+    // Largest sample sizes, both summed, whose U distribution is counted exactly.
+    const size_t EXACT_SAMPLES = 40;
+
+    double median(std::vector<double> values) {
+        std::sort(values.begin(), values.end());
+        const size_t middle = values.size() / 2;
+        return values.size() % 2 == 1 ? values[middle] : (values[middle - 1] + values[middle]) / 2;
+    }
+
+    double toSeconds(double time, const std::string &unit) {
+        if (unit == "ns") {
+            return time * 1e-9;
+        }
+        if (unit == "us") {
+            return time * 1e-6;
+        }
+        if (unit == "ms") {
+            return time * 1e-3;
+        }
+        return time;
+    }
+
+    // opencl_example: {"device", "driver", "runs": [{"name", "seconds": [...]}]}.
+    bool loadExampleResults(const JsonValue &document, BenchmarkResults &results) {
+        const JsonValue *runs = document.find("runs");
+        if (runs == nullptr || runs->type != JsonValue::Type::Array) {
+            return false;
+        }
+        results.fingerprint = document.stringOr("device", "") + " | " + document.stringOr("driver", "");
+        for (const auto &run: runs->array) {
+            const JsonValue *seconds = run.find("seconds");
+            if (seconds == nullptr) {
+                continue;
+            }
+            auto &samples = results.samples[run.stringOr("name", "")];
+            for (const auto &value: seconds->array) {
+                samples.push_back(value.number);
+            }
+        }
+        return true;
+    }
+
+    // Google Benchmark: {"context": {"device", "driver"}, "benchmarks": [{"name", "run_type", "real_time", ...}]}.
+    bool loadBenchmarkResults(const JsonValue &document, BenchmarkResults &results) {
+        const JsonValue *benchmarks = document.find("benchmarks");
+        if (benchmarks == nullptr || benchmarks->type != JsonValue::Type::Array) {
+            return false;
+        }
+        // opencl_bench adds device and driver to the context, other benchmarks only identify the host.
+        const JsonValue *context = document.find("context");
+        if (context != nullptr) {
+            results.fingerprint = context->stringOr("device", context->stringOr("host_name", "")) + " | " +
+                                  context->stringOr("driver", "");
+        }
+        for (const auto &benchmark: benchmarks->array) {
+            const JsonValue *time = benchmark.find("real_time");
+            const JsonValue *failed = benchmark.find("error_occurred");
+            // Means, medians and deviations of repetitions are derived from the samples, not samples.
+            if (time == nullptr || benchmark.stringOr("run_type", "iteration") != "iteration" ||
+                (failed != nullptr && failed->boolean)) {
+                continue;
+            }
+            results.samples[benchmark.stringOr("run_name", benchmark.stringOr("name", ""))].push_back(
+                    toSeconds(time->number, benchmark.stringOr("time_unit", "ns")));
+        }
+        return true;
+    }
+
+    // Orderings of m and n values giving each U, from f(m, n, u) = f(m - 1, n, u - n) + f(m, n - 1, u).
+    std::vector<double> uDistribution(size_t m, size_t n) {
+        std::vector<std::vector<double>> previous(n + 1), current(n + 1);
+        for (size_t j = 0; j <= n; j++) {
+            previous[j] = {1.0};
+        }
+        for (size_t i = 1; i <= m; i++) {
+            current[0] = {1.0};
+            for (size_t j = 1; j <= n; j++) {
+                current[j].assign(i * j + 1, 0.0);
+                for (size_t u = 0; u < previous[j].size(); u++) {
+                    current[j][u + j] += previous[j][u];
+                }
+                for (size_t u = 0; u < current[j - 1].size(); u++) {
+                    current[j][u] += current[j - 1][u];
+                }
+            }
+            std::swap(previous, current);
+        }
+        return previous[n];
+    }
+}
+
+bool loadResults(const std::string &path, BenchmarkResults &results, std::string &error) {
+    std::ifstream file(path);
+    if (!file) {
+        error = "cannot read " + path;
+        return false;
+    }
+    std::stringstream text;
+    text << file.rdbuf();
+    JsonValue document;
+    if (!parseJson(text.str(), document, error)) {
+        error = path + ": " + error;
+        return false;
+    }
+    results = BenchmarkResults();
+    if (!loadBenchmarkResults(document, results) && !loadExampleResults(document, results)) {
+        error = path + ": neither opencl_example nor Google Benchmark results";
+        return false;
+    }
+    return true;
+}
+
+BaselineStore::BaselineStore(const std::string &path) : path(path) {
+    std::ifstream file(path);
+    for (std::string line; std::getline(file, line);) {
+        std::istringstream fields(line);
+        Entry entry;
+        if (!std::getline(fields, entry.fingerprint, '\t') || !std::getline(fields, entry.name, '\t') ||
+            !std::getline(fields, entry.benchmark, '\t')) {
+            continue;
+        }
+        for (std::string sample; std::getline(fields, sample, '\t');) {
+            entry.samples.push_back(std::strtod(sample.c_str(), nullptr));
+        }
+        entries.push_back(std::move(entry));
+    }
+}
+
+bool BaselineStore::save(const std::string &name, const BenchmarkResults &results) {
+    std::erase_if(entries, [&](const Entry &entry) {
+        return entry.fingerprint == results.fingerprint && entry.name == name;
+    });
+    for (const auto &[benchmark, samples]: results.samples) {
+        entries.push_back({results.fingerprint, name, benchmark, samples});
+    }
+
+    std::ofstream file(path);
+    file << std::setprecision(17);
+    for (const auto &entry: entries) {
+        file << entry.fingerprint << "\t" << entry.name << "\t" << entry.benchmark;
+        for (double sample: entry.samples) {
+            file << "\t" << sample;
+        }
+        file << "\n";
+    }
+    return static_cast<bool>(file);
+}
+
+bool BaselineStore::find(const std::string &fingerprint, const std::string &name, BenchmarkResults &baseline) const {
+    baseline = BenchmarkResults{fingerprint, {}};
+    for (const auto &entry: entries) {
+        if (entry.fingerprint == fingerprint && entry.name == name) {
+            baseline.samples[entry.benchmark] = entry.samples;
+        }
+    }
+    return !baseline.samples.empty();
+}
+
+std::vector<std::pair<std::string, std::string>> BaselineStore::list() const {
+    std::vector<std::pair<std::string, std::string>> baselines;
+    for (const auto &entry: entries) {
+        std::pair<std::string, std::string> baseline{entry.fingerprint, entry.name};
+        if (std::find(baselines.begin(), baselines.end(), baseline) == baselines.end()) {
+            baselines.push_back(baseline);
+        }
+    }
+    return baselines;
+}
+
+double mannWhitneyPValue(const std::vector<double> &a, const std::vector<double> &b) {
+    const size_t m = a.size(), n = b.size();
+    if (m == 0 || n == 0) {
+        return 1;
+    }
+
+    // Ranks of the pooled samples, ties get the mean of their ranks.
+    std::vector<std::pair<double, bool>> pooled;
+    for (double value: a) {
+        pooled.emplace_back(value, true);
+    }
+    for (double value: b) {
+        pooled.emplace_back(value, false);
+    }
+    std::sort(pooled.begin(), pooled.end());
+    double rankSumA = 0, tieTerm = 0;
+    bool ties = false;
+    for (size_t i = 0; i < pooled.size();) {
+        size_t j = i;
+        while (j < pooled.size() && pooled[j].first == pooled[i].first) {
+            j++;
+        }
+        const double rank = (i + 1 + j) / 2.0;
+        for (size_t k = i; k < j; k++) {
+            rankSumA += pooled[k].second ? rank : 0;
+        }
+        const double tied = static_cast<double>(j - i);
+        tieTerm += tied * tied * tied - tied;
+        ties = ties || j - i > 1;
+        i = j;
+    }
+    const double u = rankSumA - m * (m + 1) / 2.0;
+    const double smaller = std::min(u, static_cast<double>(m * n) - u);
+
+    if (!ties && m + n <= EXACT_SAMPLES) {
+        const auto counts = uDistribution(m, n);
+        const double total = std::accumulate(counts.begin(), counts.end(), 0.0);
+        double tail = 0;
+        for (size_t k = 0; k <= static_cast<size_t>(smaller); k++) {
+            tail += counts[k];
+        }
+        return std::min(1.0, 2 * tail / total);
+    }
+
+    const double count = static_cast<double>(m + n);
+    const double variance = m * n / 12.0 * (count + 1 - tieTerm / (count * (count - 1)));
+    if (variance <= 0) {
+        return 1;
+    }
+    // Continuity corrected, smaller lies at or below the mean m * n / 2.
+    const double z = (m * n / 2.0 - smaller - 0.5) / std::sqrt(variance);
+    return std::min(1.0, std::erfc(std::max(z, 0.0) / std::sqrt(2.0)));
+}
+
+std::vector<Comparison> compareResults(const BenchmarkResults &baseline, const BenchmarkResults &current,
+                                       double threshold, double alpha) {
+    std::vector<Comparison> comparisons;
+    for (const auto &[benchmark, samples]: current.samples) {
+        auto found = baseline.samples.find(benchmark);
+        if (found == baseline.samples.end() || found->second.empty() || samples.empty()) {
+            continue;
+        }
+        Comparison comparison{benchmark, median(found->second), median(samples), 0,
+                              mannWhitneyPValue(found->second, samples), false, false};
+        comparison.change = comparison.currentMedian / comparison.baselineMedian - 1;
+        const bool significant = comparison.pValue < alpha;
+        comparison.regression = significant && comparison.change > threshold;
+        comparison.improvement = significant && comparison.change < -threshold;
+        comparisons.push_back(comparison);
+    }
+    return comparisons;
+}
+
+void printComparison(std::ostream &out, const std::vector<Comparison> &comparisons) {
+    size_t width = 9;
+    for (const auto &comparison: comparisons) {
+        width = std::max(width, comparison.benchmark.size());
+    }
+    out << std::left << std::setw(static_cast<int>(width + 2)) << "Benchmark" << std::right << std::setw(14)
+        << "Baseline (us)" << std::setw(14) << "Current (us)" << std::setw(10) << "Speedup" << std::setw(10)
+        << "Change" << std::setw(10) << "p" << "  Verdict\n";
+    for (const auto &comparison: comparisons) {
+        out << std::left << std::setw(static_cast<int>(width + 2)) << comparison.benchmark << std::right
+            << std::fixed << std::setprecision(2) << std::setw(14) << comparison.baselineMedian * 1e6
+            << std::setw(14) << comparison.currentMedian * 1e6 << std::setw(9)
+            << comparison.baselineMedian / comparison.currentMedian << "x" << std::showpos << std::setprecision(1)
+            << std::setw(9) << comparison.change * 100 << "%" << std::noshowpos << std::setprecision(4)
+            << std::setw(10) << comparison.pValue << "  "
+            << (comparison.regression ? "REGRESSION" : comparison.improvement ? "improvement" : "unchanged") << "\n";
+    }
+    out << std::defaultfloat;
+}
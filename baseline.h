@@ -0,0 +1,72 @@
+#pragma once
+
+#include <map>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// Timing samples in seconds per benchmark, from one results file.
+struct BenchmarkResults {
+    std::string fingerprint;    // Device and driver the results were measured on
+    std::map<std::string, std::vector<double>> samples;
+};
+
+/**
+ * Reads the output of opencl_example --format json, one sample per timed run, or of opencl_bench
+ * --benchmark_format=json, one sample per repetition. Returns false with error on unreadable files.
+ **/
+bool loadResults(const std::string &path, BenchmarkResults &results, std::string &error);
+
+/**
+ * Named baselines per device fingerprint, kept in a file with one tab separated line per
+ * benchmark: fingerprint, baseline name, benchmark name, then its samples.
+ **/
+class BaselineStore {
+public:
+    explicit BaselineStore(const std::string &path);
+
+    // Replaces the baseline of that name for the fingerprint of results, and writes the file.
+    bool save(const std::string &name, const BenchmarkResults &results);
+
+    // The baseline of that name for fingerprint, false if there is none.
+    bool find(const std::string &fingerprint, const std::string &name, BenchmarkResults &baseline) const;
+
+    // Fingerprint and name of each stored baseline.
+    std::vector<std::pair<std::string, std::string>> list() const;
+
+private:
+    struct Entry {
+        std::string fingerprint;
+        std::string name;
+        std::string benchmark;
+        std::vector<double> samples;
+    };
+
+    std::string path;
+    std::vector<Entry> entries;
+};
+
+/**
+ * Two-sided p-value of the Mann-Whitney U test that a and b come from the same distribution.
+ * Exact for small samples without ties, else from the normal approximation with tie correction.
+ **/
+double mannWhitneyPValue(const std::vector<double> &a, const std::vector<double> &b);
+
+struct Comparison {
+    std::string benchmark;
+    double baselineMedian;
+    double currentMedian;
+    double change;          // currentMedian / baselineMedian - 1, positive when slower
+    double pValue;
+    bool regression;
+    bool improvement;
+};
+
+/**
+ * Compares the benchmarks present in both. A change counts when its median moves by more than
+ * threshold (a fraction) and the U test rejects equal distributions at alpha.
+ **/
+std::vector<Comparison> compareResults(const BenchmarkResults &baseline, const BenchmarkResults &current,
+                                       double threshold, double alpha);
+
+void printComparison(std::ostream &out, const std::vector<Comparison> &comparisons);
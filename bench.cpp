@@ -0,0 +1,188 @@
+#include "host.h"
+#include "launch.h"
+#include "options.h"
+#include "program.h"
+#include "transfer.h"
+
+#include <benchmark/benchmark.h>
+#include <CL/opencl.hpp>
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+    const std::string KERNEL_PROGRAM_FILE = "kernel.cl";
+    // Vector sizes run from this one up to the --size option, growing 16 times per step.
+    const size_t MIN_SIZE = 4096;
+    const MemoryMode MEMORY_MODES[] = {MemoryMode::UseHostPtr, MemoryMode::CopyHostPtr, MemoryMode::AllocHostPtr,
+                                       MemoryMode::Device};
+    const TransferStrategy STRATEGIES[] = {TransferStrategy::Pageable, TransferStrategy::PinnedStaging,
+                                           TransferStrategy::CopyHostPtr, TransferStrategy::UseHostPtr,
+                                           TransferStrategy::MapUnmap};
+
+    Options options;
+
+    // The device under test, set up once for all benchmarks. The queue profiles, so kernels are timed by the device.
+    struct Setup {
+        cl::Device device;
+        cl::Context context;
+        cl::Program program;
+        cl::CommandQueue queue;
+    };
+
+    std::unique_ptr<Setup> setup;
+
+    struct Vectors {
+        std::vector<float> a, b, c;
+
+        explicit Vectors(size_t size) : a(size, 1.5f), b(size, 2.5f), c(size) {}
+    };
+
+    void setBytesProcessed(benchmark::State &state, size_t size) {
+        state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * 3 * sizeof(float) * size));
+    }
+
+    // Like computeInSequence in main.cpp.
+    void hostScalar(benchmark::State &state, size_t size) {
+        Vectors vectors(size);
+        for (auto _: state) {
+            for (size_t i = 0; i < size; i++) {
+                vectors.c[i] = options.scalar * vectors.a[i] + vectors.b[i] * vectors.a[i];
+            }
+            benchmark::DoNotOptimize(vectors.c.data());
+            benchmark::ClobberMemory();
+        }
+        setBytesProcessed(state, size);
+    }
+
+    void hostThreads(benchmark::State &state, size_t size, unsigned threads) {
+        Vectors vectors(size);
+        for (auto _: state) {
+            if (threads == 1) {
+                vaddOnHost(options.scalar, vectors.a.data(), vectors.b.data(), vectors.c.data(), size);
+            } else {
+                vaddOnHostThreads(options.scalar, vectors.a.data(), vectors.b.data(), vectors.c.data(), size, threads);
+            }
+            benchmark::DoNotOptimize(vectors.c.data());
+            benchmark::ClobberMemory();
+        }
+        setBytesProcessed(state, size);
+    }
+
+    // Times launches only, with the inputs placed once as in computeInParallel.
+    void kernel(benchmark::State &state, KernelVariant variant, MemoryMode mode, size_t size) {
+        Vectors vectors(size);
+        const size_t bytes = sizeof(float) * size;
+        cl::Buffer aBuf = createInputBuffer(setup->context, setup->queue, mode, vectors.a.data(), bytes);
+        cl::Buffer bBuf = createInputBuffer(setup->context, setup->queue, mode, vectors.b.data(), bytes);
+        cl::Buffer cBuf(setup->context, CL_MEM_WRITE_ONLY, bytes);
+
+        cl::Kernel kernel(setup->program, variantName(variant).c_str());
+        kernel.setArg(0, options.scalar);
+        kernel.setArg(1, aBuf);
+        kernel.setArg(2, bBuf);
+        kernel.setArg(3, cBuf);
+        cl::NDRange global(size);
+        if (variant == KernelVariant::GridStride) {
+            kernel.setArg(4, static_cast<cl_uint>(size));
+            global = cl::NDRange(gridStrideGlobalSize(kernel, setup->device, size, options.localSize, options.unroll));
+        }
+        const cl::NDRange local = options.localSize > 0 ? cl::NDRange(options.localSize) : cl::NullRange;
+
+        for (auto _: state) {
+            cl::Event computeEvent;
+            if (setup->queue.enqueueNDRangeKernel(kernel, cl::NullRange, global, local, nullptr, &computeEvent) !=
+                CL_SUCCESS) {
+                state.SkipWithError("kernel launch failed");
+                break;
+            }
+            computeEvent.wait();
+            const cl_ulong start = computeEvent.getProfilingInfo<CL_PROFILING_COMMAND_START>();
+            const cl_ulong end = computeEvent.getProfilingInfo<CL_PROFILING_COMMAND_END>();
+            state.SetIterationTime(static_cast<double>(end - start) * 1e-9);
+        }
+        setBytesProcessed(state, size);
+    }
+
+    // One transfer per iteration, timed on the host since it includes synchronisation and buffer creation.
+    void transfer(benchmark::State &state, TransferStrategy strategy, TransferDirection direction, bool blocking,
+                  size_t size) {
+        std::vector<float> host(size, 1.0f);
+        for (auto _: state) {
+            state.SetIterationTime(measureTransfer(setup->context, setup->queue, strategy, direction, blocking,
+                                                   host.data(), sizeof(float) * size, 1));
+        }
+        state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * sizeof(float) * size));
+    }
+
+    // Multiples of the local size, since vadd has no bounds check and needs full work-groups.
+    std::vector<size_t> sizes() {
+        const size_t multiple = std::max<size_t>(options.localSize, 1);
+        std::vector<size_t> sizes;
+        for (size_t size = MIN_SIZE; size < options.size; size *= 16) {
+            sizes.push_back((size + multiple - 1) / multiple * multiple);
+        }
+        sizes.push_back(options.size);
+        return sizes;
+    }
+
+    void registerBenchmarks() {
+        const unsigned threads = std::max(std::thread::hardware_concurrency(), 1u);
+        for (size_t size: sizes()) {
+            const std::string suffix = std::string("/") + std::to_string(size);
+            benchmark::RegisterBenchmark(("host/scalar" + suffix).c_str(), hostScalar, size);
+            benchmark::RegisterBenchmark(("host/simd" + suffix).c_str(), hostThreads, size, 1u);
+            benchmark::RegisterBenchmark(("host/simd threads:" + std::to_string(threads) + suffix).c_str(),
+                                         hostThreads, size, threads)->UseRealTime();
+            for (auto variant: {KernelVariant::Simple, KernelVariant::GridStride}) {
+                for (auto mode: MEMORY_MODES) {
+                    benchmark::RegisterBenchmark(("kernel/" + variantName(variant) + "/" + memoryModeName(mode) +
+                                                  suffix).c_str(), kernel, variant, mode, size)->UseManualTime();
+                }
+            }
+            for (auto strategy: STRATEGIES) {
+                for (auto direction: {TransferDirection::HostToDevice, TransferDirection::DeviceToHost}) {
+                    for (bool blocking: {true, false}) {
+                        if (!isApplicable(strategy, direction, blocking)) {
+                            continue;
+                        }
+                        const std::string name = "transfer/" + strategyName(strategy) +
+                                                 (direction == TransferDirection::HostToDevice ? "/to device"
+                                                                                                : "/to host") +
+                                                 (blocking ? "/blocking" : "/non-blocking") + suffix;
+                        benchmark::RegisterBenchmark(name.c_str(), transfer, strategy, direction, blocking, size)
+                                ->UseManualTime();
+                    }
+                }
+            }
+        }
+    }
+}
+
+/**
+ * Benchmarks every compute path of opencl_example on its first selected device. Google Benchmark
+ * takes its --benchmark_* flags first, the remaining arguments and OPENCL_EXAMPLE_* variables are
+ * the options of opencl_example, of which size, device selection, local size and unroll apply.
+ **/
+int main(int argc, char *argv[]) {
+    benchmark::Initialize(&argc, argv);
+    options = parseOptions(argc, argv);
+
+    cl::Device device = selectDevices(options).front();
+    cl::Context context(device);
+    const std::string buildOptions = options.unroll == Options().unroll
+                                     ? "" : "-DVADD_UNROLL=" + std::to_string(options.unroll);
+    cl::Program program = buildProgram(context, device, KERNEL_PROGRAM_FILE, buildOptions);
+    setup = std::make_unique<Setup>(Setup{device, context, program,
+                                          cl::CommandQueue(context, device, CL_QUEUE_PROFILING_ENABLE)});
+    benchmark::AddCustomContext("device", device.getInfo<CL_DEVICE_NAME>());
+    benchmark::AddCustomContext("driver", device.getInfo<CL_DRIVER_VERSION>());
+
+    registerBenchmarks();
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    setup.reset();
+}
@@ -0,0 +1,47 @@
+#include "blocks.h"
+
+#include <iterator>
+
+FreeBlocks::FreeBlocks(size_t bytes) {
+    if (bytes > 0) {
+        free.emplace(0, bytes);
+    }
+}
+
+bool FreeBlocks::take(size_t bytes, size_t alignment, size_t &offset) {
+    for (auto block = free.begin(); block != free.end(); ++block) {
+        auto [start, size] = *block;
+        const size_t aligned = (start + alignment - 1) / alignment * alignment;
+        if (aligned + bytes > start + size) {
+            continue;
+        }
+        free.erase(block);
+        // Keep the padding in front and the rest behind the block free.
+        if (aligned > start) {
+            free.emplace(start, aligned - start);
+        }
+        if (aligned + bytes < start + size) {
+            free.emplace(aligned + bytes, start + size - aligned - bytes);
+        }
+        offset = aligned;
+        return true;
+    }
+    return false;
+}
+
+void FreeBlocks::give(size_t offset, size_t bytes) {
+    auto next = free.lower_bound(offset);
+    if (next != free.end() && offset + bytes == next->first) {
+        bytes += next->second;
+        next = free.erase(next);
+    }
+    if (next != free.begin()) {
+        auto previous = std::prev(next);
+        if (previous->first + previous->second == offset) {
+            offset = previous->first;
+            bytes += previous->second;
+            free.erase(previous);
+        }
+    }
+    free.emplace(offset, bytes);
+}
@@ -0,0 +1,22 @@
+#pragma once
+
+#include <cstddef>
+#include <map>
+
+/**
+ * First-fit free list over one region of memory, shared by the host memory pools. Offsets and
+ * sizes are in bytes; callers round sizes so that the blocks keep the alignment they need.
+ **/
+class FreeBlocks {
+public:
+    explicit FreeBlocks(size_t bytes);
+
+    // Offset of a free block of `bytes` starting at a multiple of `alignment`, false if none is left.
+    bool take(size_t bytes, size_t alignment, size_t &offset);
+
+    // Returns a block, merging it with its free neighbours so large blocks can be handed out again.
+    void give(size_t offset, size_t bytes);
+
+private:
+    std::map<size_t, size_t> free;    // Sizes of the free blocks by offset
+};
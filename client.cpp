@@ -0,0 +1,177 @@
+#include "client.h"
+
+#include <atomic>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace {
+
+    const size_t PAGE_SIZE = 4096;
+
+    size_t alignToPage(size_t bytes) {
+        return (bytes + PAGE_SIZE - 1) / PAGE_SIZE * PAGE_SIZE;
+    }
+}
+
+ComputeClient::ComputeClient(const std::string &socketPath) {
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    if (socketPath.size() >= sizeof(address.sun_path)) {
+        return;
+    }
+    std::strncpy(address.sun_path, socketPath.c_str(), sizeof(address.sun_path) - 1);
+
+    fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd >= 0 && connect(fd, reinterpret_cast<sockaddr *>(&address), sizeof(address)) != 0) {
+        close(fd);
+        fd = -1;
+    }
+}
+
+ComputeClient::~ComputeClient() {
+    detachSharedMemory();
+    if (fd >= 0) {
+        close(fd);
+    }
+}
+
+bool ComputeClient::isConnected() const {
+    return fd >= 0;
+}
+
+protocol::Status ComputeClient::vadd(float a, const std::vector<float> &x, const std::vector<float> &y,
+                                     std::vector<float> &result) {
+    if (x.size() != y.size()) {
+        return protocol::Status::BadRequest;
+    }
+    return call(protocol::Operation::Vadd, a, {x.data(), y.data()}, x.size(), result);
+}
+
+protocol::Status ComputeClient::call(protocol::Operation operation, float scalar,
+                                     const std::vector<const float *> &inputs, size_t count,
+                                     std::vector<float> &result) {
+    protocol::RequestHeader request;
+    request.operation = static_cast<uint16_t>(operation);
+    request.inputs = static_cast<uint16_t>(inputs.size());
+    request.count = count;
+    request.scalar = scalar;
+    return exchange(request, {inputs.begin(), inputs.end()},
+                    std::vector<size_t>(inputs.size(), sizeof(float) * count), &result);
+}
+
+protocol::Status ComputeClient::attachSharedMemory(size_t bytes) {
+    static std::atomic<int> regions = 0;
+    detachSharedMemory();
+
+    const std::string name = "/opencl_example-" + std::to_string(getpid()) + "-" + std::to_string(regions++);
+    int shm = shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+    if (shm < 0) {
+        return protocol::Status::BadRequest;
+    }
+    bytes = alignToPage(bytes);
+    void *mapped = ftruncate(shm, static_cast<off_t>(bytes)) == 0
+                   ? mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, shm, 0) : MAP_FAILED;
+    close(shm);
+
+    auto status = protocol::Status::BadRequest;
+    if (mapped != MAP_FAILED) {
+        shared = static_cast<char *>(mapped);
+        sharedBytes = bytes;
+        sharedUsed = 0;
+
+        protocol::RequestHeader request;
+        request.operation = static_cast<uint16_t>(protocol::Operation::AttachSharedMemory);
+        request.count = name.size();
+        status = exchange(request, {name.data()}, {name.size()}, nullptr);
+        if (status != protocol::Status::Ok) {
+            detachSharedMemory();
+        }
+    }
+    // Both sides have it mapped now, so the name is no longer needed and cannot leak.
+    shm_unlink(name.c_str());
+    return status;
+}
+
+void ComputeClient::detachSharedMemory() {
+    if (shared != nullptr) {
+        munmap(shared, sharedBytes);
+        shared = nullptr;
+        sharedBytes = 0;
+        sharedUsed = 0;
+    }
+}
+
+float *ComputeClient::allocateShared(size_t count) {
+    const size_t bytes = alignToPage(sizeof(float) * count);
+    if (shared == nullptr || bytes > sharedBytes - sharedUsed) {
+        return nullptr;
+    }
+    auto *array = reinterpret_cast<float *>(shared + sharedUsed);
+    sharedUsed += bytes;
+    return array;
+}
+
+void ComputeClient::resetShared() {
+    sharedUsed = 0;
+}
+
+protocol::Status ComputeClient::vaddShared(float a, const float *x, const float *y, float *result, size_t count) {
+    return callShared(protocol::Operation::Vadd, a, {x, y}, count, result);
+}
+
+protocol::Status ComputeClient::callShared(protocol::Operation operation, float scalar,
+                                           const std::vector<const float *> &inputs, size_t count, float *result) {
+    if (shared == nullptr) {
+        return protocol::Status::BadRequest;
+    }
+
+    std::vector<uint64_t> offsets;
+    for (const float *input: inputs) {
+        offsets.push_back(reinterpret_cast<const char *>(input) - shared);
+    }
+    offsets.push_back(reinterpret_cast<const char *>(result) - shared);
+
+    protocol::RequestHeader request;
+    request.operation = static_cast<uint16_t>(operation);
+    request.inputs = static_cast<uint16_t>(inputs.size());
+    request.count = count;
+    request.scalar = scalar;
+    request.flags = protocol::SHARED_MEMORY;
+    return exchange(request, {offsets.data()}, {sizeof(uint64_t) * offsets.size()}, nullptr);
+}
+
+protocol::Status ComputeClient::exchange(const protocol::RequestHeader &header,
+                                         const std::vector<const void *> &payload,
+                                         const std::vector<size_t> &payloadBytes, std::vector<float> *result) {
+    if (fd < 0) {
+        return protocol::Status::ConnectionError;
+    }
+
+    protocol::RequestHeader request = header;
+    request.requestId = nextRequestId++;
+    bool sent = protocol::writeAll(fd, &request, sizeof(request));
+    for (size_t i = 0; sent && i < payload.size(); i++) {
+        sent = protocol::writeAll(fd, payload[i], payloadBytes[i]);
+    }
+
+    protocol::ResponseHeader response;
+    bool received = sent && protocol::readAll(fd, &response, sizeof(response)) &&
+                    response.magic == protocol::MAGIC && response.requestId == request.requestId;
+    if (received && result != nullptr) {
+        result->resize(response.count);
+        received = protocol::readAll(fd, result->data(), sizeof(float) * response.count);
+    } else if (received) {
+        received = response.count == 0;
+    }
+
+    if (!received) {
+        close(fd);
+        fd = -1;
+        return protocol::Status::ConnectionError;
+    }
+    return static_cast<protocol::Status>(response.status);
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include "protocol.h"
+
+#include <string>
+#include <vector>
+
+/**
+ * Connection to a running opencl_daemon. Calls are synchronous and one connection serves one
+ * request at a time, use a client per thread for concurrency.
+ **/
+class ComputeClient {
+public:
+    explicit ComputeClient(const std::string &socketPath);
+
+    ~ComputeClient();
+
+    ComputeClient(const ComputeClient &) = delete;
+
+    ComputeClient &operator=(const ComputeClient &) = delete;
+
+    bool isConnected() const;
+
+    // result = a * x + y * x, result is resized to x.size().
+    protocol::Status vadd(float a, const std::vector<float> &x, const std::vector<float> &y,
+                          std::vector<float> &result);
+
+    // Runs any registered operation on equally sized inputs.
+    protocol::Status call(protocol::Operation operation, float scalar, const std::vector<const float *> &inputs,
+                          size_t count, std::vector<float> &result);
+
+    /**
+     * Creates a shared memory region of at least `bytes` and has the daemon map it, replacing
+     * any earlier region. Arrays allocated from it are passed to the *Shared calls without copies.
+     **/
+    protocol::Status attachSharedMemory(size_t bytes);
+
+    // Page-aligned array of `count` floats in the region, nullptr when it does not fit.
+    float *allocateShared(size_t count);
+
+    // Releases every array allocated from the region.
+    void resetShared();
+
+    // result = a * x + y * x where x, y and result were allocated from the shared region.
+    protocol::Status vaddShared(float a, const float *x, const float *y, float *result, size_t count);
+
+    protocol::Status callShared(protocol::Operation operation, float scalar, const std::vector<const float *> &inputs,
+                                size_t count, float *result);
+
+private:
+    protocol::Status exchange(const protocol::RequestHeader &request, const std::vector<const void *> &payload,
+                              const std::vector<size_t> &payloadBytes, std::vector<float> *result);
+
+    void detachSharedMemory();
+
+    int fd = -1;
+    uint64_t nextRequestId = 1;
+    char *shared = nullptr;
+    size_t sharedBytes = 0;
+    size_t sharedUsed = 0;
+};
@@ -0,0 +1,118 @@
+# Embeds OpenCL kernel sources into the executable and, when an offline compiler is
+# available, precompiles them so the runtime can skip the source compile.
+#
+# Included from CMakeLists.txt it provides embed_kernels(); run with `cmake -P` it
+# generates the header (that is how embed_kernels() invokes it at build time).
+
+if(CMAKE_SCRIPT_MODE_FILE)
+    # Appends `file` to `out` as a C string literal split over several lines.
+    function(append_string_literal out file)
+        file(READ ${file} hex HEX)
+        string(REPEAT "[0-9a-f]" 32 line)
+        string(REGEX REPLACE "(${line})" "\\1\n" hex "${hex}")
+        string(REGEX REPLACE "([0-9a-f][0-9a-f])" "\\\\x\\1" hex "${hex}")
+        string(REPLACE "\n" "\"\n    \"" hex "${hex}")
+        set(${out} "${${out}}    \"${hex}\"" PARENT_SCOPE)
+    endfunction()
+
+    # Appends `file` to `out` as the initializer of an unsigned char array.
+    function(append_byte_array out file)
+        file(READ ${file} hex HEX)
+        string(REPEAT "[0-9a-f]" 32 line)
+        string(REGEX REPLACE "(${line})" "\\1\n" hex "${hex}")
+        string(REGEX REPLACE "([0-9a-f][0-9a-f])" "0x\\1," hex "${hex}")
+        string(REPLACE "\n" "\n    " hex "${hex}")
+        set(${out} "${${out}}    ${hex}" PARENT_SCOPE)
+    endfunction()
+
+    string(REPLACE "|" ";" SOURCES "${SOURCES}")
+    set(content "// Generated by cmake/EmbedKernels.cmake, do not edit.\n#pragma once\n\n")
+    string(APPEND content "#include <span>\n#include <string_view>\n\nnamespace embedded {\n\n")
+    string(APPEND content "struct KernelFile {\n")
+    string(APPEND content "    std::string_view name;                  // File name of the kernel, e.g. \"kernel.cl\"\n")
+    string(APPEND content "    std::string_view source;                // OpenCL C source\n")
+    string(APPEND content "    std::span<const unsigned char> spirv;   // SPIR-V compiled at build time, empty if unavailable\n")
+    string(APPEND content "    std::span<const unsigned char> binary;  // Device binary compiled at build time, empty if unavailable\n")
+    string(APPEND content "};\n\n")
+
+    set(entries "")
+    foreach(src ${SOURCES})
+        get_filename_component(name ${src} NAME)
+        get_filename_component(stem ${src} NAME_WE)
+        string(MAKE_C_IDENTIFIER ${stem} id)
+
+        string(APPEND content "inline constexpr char ${id}_source[] =\n")
+        append_string_literal(content ${src})
+        string(APPEND content ";\n\n")
+        set(entry "{\"${name}\", {${id}_source, sizeof(${id}_source) - 1}")
+
+        foreach(kind spirv binary)
+            set(artifact ${GEN_DIR}/${stem}.${kind})
+            if(EXISTS ${artifact})
+                string(APPEND content "inline constexpr unsigned char ${id}_${kind}[] = {\n")
+                append_byte_array(content ${artifact})
+                string(APPEND content "\n};\n\n")
+                string(APPEND entry ", ${id}_${kind}")
+            else()
+                string(APPEND entry ", {}")
+            endif()
+        endforeach()
+        string(APPEND entries "    ${entry}},\n")
+    endforeach()
+
+    string(APPEND content "inline constexpr KernelFile KERNEL_FILES[] = {\n${entries}};\n\n}\n")
+    file(WRITE ${OUTPUT} "${content}")
+    return()
+endif()
+
+option(PRECOMPILE_KERNELS "Precompile kernels at build time when an offline OpenCL compiler is found" ON)
+find_program(CLANG_EXECUTABLE NAMES clang)
+find_program(LLVM_SPIRV_EXECUTABLE NAMES llvm-spirv)
+find_program(POCLCC_EXECUTABLE NAMES poclcc)
+set(EMBED_KERNELS_SCRIPT ${CMAKE_CURRENT_LIST_FILE})
+
+# embed_kernels(<header-var> <kernel.cl>...)
+# Generates embedded_kernels.h in the build tree and stores its path in <header-var>;
+# list that path among the sources of every target that includes the header.
+function(embed_kernels header_var)
+    set(gen_dir ${CMAKE_CURRENT_BINARY_DIR}/generated)
+    set(header ${gen_dir}/embedded_kernels.h)
+    file(MAKE_DIRECTORY ${gen_dir})
+
+    set(sources "")
+    set(depends ${EMBED_KERNELS_SCRIPT})
+    foreach(src ${ARGN})
+        get_filename_component(src ${src} ABSOLUTE)
+        get_filename_component(stem ${src} NAME_WE)
+        list(APPEND sources ${src})
+        list(APPEND depends ${src})
+
+        if(PRECOMPILE_KERNELS AND CLANG_EXECUTABLE AND LLVM_SPIRV_EXECUTABLE)
+            add_custom_command(OUTPUT ${gen_dir}/${stem}.spirv
+                    COMMAND ${CLANG_EXECUTABLE} -cl-std=CL1.2 -target spir64 -O2 -emit-llvm -c ${src} -o ${gen_dir}/${stem}.bc
+                    COMMAND ${LLVM_SPIRV_EXECUTABLE} ${gen_dir}/${stem}.bc -o ${gen_dir}/${stem}.spirv
+                    DEPENDS ${src}
+                    COMMENT "Compiling ${stem} kernels to SPIR-V"
+                    VERBATIM)
+            list(APPEND depends ${gen_dir}/${stem}.spirv)
+        endif()
+
+        # poclcc targets the first device POCL reports, which matches the build host.
+        if(PRECOMPILE_KERNELS AND POCLCC_EXECUTABLE)
+            add_custom_command(OUTPUT ${gen_dir}/${stem}.binary
+                    COMMAND ${POCLCC_EXECUTABLE} -o ${gen_dir}/${stem}.binary ${src}
+                    DEPENDS ${src}
+                    COMMENT "Compiling ${stem} kernels to a POCL device binary"
+                    VERBATIM)
+            list(APPEND depends ${gen_dir}/${stem}.binary)
+        endif()
+    endforeach()
+
+    string(REPLACE ";" "|" sources "${sources}")
+    add_custom_command(OUTPUT ${header}
+            COMMAND ${CMAKE_COMMAND} -DOUTPUT=${header} -DGEN_DIR=${gen_dir} -DSOURCES=${sources} -P ${EMBED_KERNELS_SCRIPT}
+            DEPENDS ${depends}
+            COMMENT "Embedding OpenCL kernels"
+            VERBATIM)
+    set(${header_var} ${header} PARENT_SCOPE)
+endfunction()
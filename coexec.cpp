@@ -0,0 +1,91 @@
+#include "coexec.h"
+#include "host.h"
+
+#include <algorithm>
+#include <chrono>
+
+namespace {
+
+    // Calibration runs each side alone on this many elements at most.
+    const size_t CALIBRATION_ELEMENTS = 1 << 18;
+    // Weight of the newest measurement, older ones fade out to follow throttling and load.
+    const double SMOOTHING = 0.5;
+    // The split is rounded to whole cache lines.
+    const size_t ALIGNMENT = 16;
+
+    double smooth(double previous, double measured) {
+        return previous == 0 ? measured : (1 - SMOOTHING) * previous + SMOOTHING * measured;
+    }
+}
+
+CoExecutor::CoExecutor(const cl::Context &context, const cl::Device &device, const cl::Program &program,
+                       unsigned hostThreads)
+        : context(context), queue(context, device, CL_QUEUE_PROFILING_ENABLE), kernel(program, "vadd"),
+          hostThreads(hostThreads) {
+}
+
+double CoExecutor::hostFraction() const {
+    if (hostThroughput + deviceThroughput == 0) {
+        return 0.5;
+    }
+    return hostThroughput / (hostThroughput + deviceThroughput);
+}
+
+void CoExecutor::vadd(float a, std::span<const float> x, std::span<const float> y,
+                      std::span<float> result) {
+    if (hostThroughput == 0 || deviceThroughput == 0) {
+        calibrate(a, x, y, result);
+    }
+
+    const size_t n = x.size();
+    size_t hostCount = static_cast<size_t>(hostFraction() * n) / ALIGNMENT * ALIGNMENT;
+    run(a, x.data(), y.data(), result.data(), n, std::min(hostCount, n));
+}
+
+void CoExecutor::calibrate(float a, std::span<const float> x, std::span<const float> y,
+                           std::span<float> result) {
+    const size_t n = std::min(x.size(), CALIBRATION_ELEMENTS);
+    run(a, x.data(), y.data(), result.data(), n, n);
+    run(a, x.data(), y.data(), result.data(), n, 0);
+}
+
+void CoExecutor::run(float a, const float *x, const float *y, float *result, size_t n, size_t hostCount) {
+    const size_t deviceCount = n - hostCount;
+
+    // Start the device part first so it runs while the host threads compute theirs. Its result buffer wraps the
+    // device's part of result, mapping it afterwards makes the host see the values without a copy.
+    const size_t bytes = sizeof(float) * deviceCount;
+    cl::Buffer cBuf;
+    cl::Event computeEvent, readEvent;
+    void *mapped = nullptr;
+    if (deviceCount > 0) {
+        cl::Buffer aBuf(context, CL_MEM_READ_ONLY | CL_MEM_USE_HOST_PTR, bytes, const_cast<float *>(x + hostCount));
+        cl::Buffer bBuf(context, CL_MEM_READ_ONLY | CL_MEM_USE_HOST_PTR, bytes, const_cast<float *>(y + hostCount));
+        cBuf = cl::Buffer(context, CL_MEM_WRITE_ONLY | CL_MEM_USE_HOST_PTR, bytes, result + hostCount);
+        kernel.setArg(0, a);
+        kernel.setArg(1, aBuf);
+        kernel.setArg(2, bBuf);
+        kernel.setArg(3, cBuf);
+        queue.enqueueNDRangeKernel(kernel, cl::NullRange, cl::NDRange(deviceCount), cl::NullRange, nullptr,
+                                   &computeEvent);
+        mapped = queue.enqueueMapBuffer(cBuf, CL_FALSE, CL_MAP_READ, 0, bytes, nullptr, &readEvent);
+        queue.flush();
+    }
+
+    if (hostCount > 0) {
+        auto start_time = std::chrono::high_resolution_clock::now();
+        vaddOnHostThreads(a, x, y, result, hostCount, hostThreads);
+        std::chrono::duration<double> hostTime = std::chrono::high_resolution_clock::now() - start_time;
+        hostThroughput = smooth(hostThroughput, hostCount / hostTime.count());
+    }
+
+    if (deviceCount > 0) {
+        // Profiling times the device alone, the host may still have been busy when it finished.
+        readEvent.wait();
+        double deviceSeconds = (readEvent.getProfilingInfo<CL_PROFILING_COMMAND_END>() -
+                                computeEvent.getProfilingInfo<CL_PROFILING_COMMAND_QUEUED>()) * 1e-9;
+        deviceThroughput = smooth(deviceThroughput, deviceCount / deviceSeconds);
+        queue.enqueueUnmapMemObject(cBuf, mapped);
+        queue.finish();
+    }
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <CL/opencl.hpp>
+#include <span>
+#include <vector>
+
+/**
+ * Computes vadd on host threads and an OpenCL device at the same time. The host takes the
+ * front of the vector and the device the rest, both writing straight into the result. The
+ * split follows the throughputs measured on every call, starting from a calibration run.
+ **/
+class CoExecutor {
+public:
+    CoExecutor(const cl::Context &context, const cl::Device &device, const cl::Program &program,
+               unsigned hostThreads);
+
+    void vadd(float a, std::span<const float> x, std::span<const float> y, std::span<float> result);
+
+    // Share of the elements the next call gives to the host.
+    double hostFraction() const;
+
+private:
+    // Computes elements [0, hostCount) on the host and the rest on the device.
+    void run(float a, const float *x, const float *y, float *result, size_t n, size_t hostCount);
+
+    void calibrate(float a, std::span<const float> x, std::span<const float> y, std::span<float> result);
+
+    cl::Context context;
+    cl::CommandQueue queue;
+    cl::Kernel kernel;
+    unsigned hostThreads;
+    double hostThroughput = 0;    // Elements per second, smoothed over calls
+    double deviceThroughput = 0;
+};
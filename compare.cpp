@@ -0,0 +1,122 @@
+#include <iostream>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include "baseline.h"
+
+const std::string DEFAULT_STORE_FILE = "benchmark_baselines.tsv";
+// Median slowdowns up to this many percent pass even when significant.
+const double DEFAULT_THRESHOLD_PERCENT = 5;
+const double DEFAULT_ALPHA = 0.05;
+// Exit status on regressions, errors exit with 2 so that checks can tell them apart.
+const int REGRESSION_STATUS = 1;
+const int ERROR_STATUS = 2;
+
+void printUsage(std::ostream &out) {
+    out << "Usage: opencl_compare save <results.json> <baseline> [--store file]\n"
+           "       opencl_compare compare <results.json> <baseline> [--threshold percent] [--alpha p] [--store file]\n"
+           "       opencl_compare list [--store file]\n"
+           "Results are opencl_example --format json or opencl_bench --benchmark_format=json output, use\n"
+           "--iterations or --benchmark_repetitions for several samples per benchmark. Baselines are kept per\n"
+           "device and driver in " << DEFAULT_STORE_FILE << " unless --store is given. compare exits with "
+        << REGRESSION_STATUS << " when a\nbenchmark's median got slower by more than --threshold (default "
+        << DEFAULT_THRESHOLD_PERCENT << "%) and a Mann-Whitney U test\nrejects equal timings at --alpha (default "
+        << DEFAULT_ALPHA << "), and with " << ERROR_STATUS << " on errors.\n";
+}
+
+[[noreturn]] void fail(const std::string &message) {
+    std::cerr << message << std::endl;
+    std::exit(ERROR_STATUS);
+}
+
+BenchmarkResults load(const std::string &path) {
+    BenchmarkResults results;
+    std::string error;
+    if (!loadResults(path, results, error)) {
+        fail(error);
+    }
+    return results;
+}
+
+int main(int argc, char *argv[]) {
+    std::vector<std::string> positional;
+    std::string storeFile = DEFAULT_STORE_FILE;
+    double thresholdPercent = DEFAULT_THRESHOLD_PERCENT, alpha = DEFAULT_ALPHA;
+    for (int i = 1; i < argc; i++) {
+        const std::string argument = argv[i];
+        if (argument == "--help") {
+            printUsage(std::cout);
+            return 0;
+        }
+        if (argument.rfind("--", 0) != 0) {
+            positional.push_back(argument);
+            continue;
+        }
+        if (i + 1 == argc) {
+            printUsage(std::cerr);
+            return ERROR_STATUS;
+        }
+        const std::string value = argv[++i];
+        char *end = nullptr;
+        if (argument == "--store") {
+            storeFile = value;
+        } else if (argument == "--threshold") {
+            thresholdPercent = std::strtod(value.c_str(), &end);
+        } else if (argument == "--alpha") {
+            alpha = std::strtod(value.c_str(), &end);
+        } else {
+            printUsage(std::cerr);
+            return ERROR_STATUS;
+        }
+        if (end != nullptr && (*end != '\0' || end == value.c_str())) {
+            fail("Invalid value for " + argument + ": " + value);
+        }
+    }
+
+    const std::string command = positional.empty() ? "" : positional[0];
+    BaselineStore store(storeFile);
+    if (command == "list" && positional.size() == 1) {
+        for (const auto &[fingerprint, name]: store.list()) {
+            std::cout << name << "\t" << fingerprint << "\n";
+        }
+        return 0;
+    }
+    if (positional.size() != 3 || (command != "save" && command != "compare")) {
+        printUsage(std::cerr);
+        return ERROR_STATUS;
+    }
+
+    const BenchmarkResults current = load(positional[1]);
+    const std::string &name = positional[2];
+    if (command == "save") {
+        if (!store.save(name, current)) {
+            fail("Cannot write " + storeFile);
+        }
+        std::cout << "Saved " << current.samples.size() << " benchmarks as baseline " << name << " for "
+                  << current.fingerprint << "\n";
+        return 0;
+    }
+
+    BenchmarkResults baseline;
+    if (!store.find(current.fingerprint, name, baseline)) {
+        fail("No baseline " + name + " for " + current.fingerprint + " in " + storeFile);
+    }
+    const auto comparisons = compareResults(baseline, current, thresholdPercent / 100, alpha);
+    std::cout << "Comparing with baseline " << name << " on " << current.fingerprint << ":\n";
+    printComparison(std::cout, comparisons);
+
+    int regressions = 0;
+    for (const auto &comparison: comparisons) {
+        regressions += comparison.regression;
+    }
+    const size_t unmatched = current.samples.size() - comparisons.size();
+    if (unmatched > 0) {
+        std::cout << unmatched << " benchmarks have no baseline yet\n";
+    }
+    if (regressions > 0) {
+        std::cout << regressions << " of " << comparisons.size() << " benchmarks regressed" << std::endl;
+        return REGRESSION_STATUS;
+    }
+    return 0;
+}
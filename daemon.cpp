@@ -0,0 +1,65 @@
+#include <iostream>
+#include <CL/opencl.hpp>
+#include <algorithm>
+#include <csignal>
+#include <cstdlib>
+
+#include "program.h"
+#include "ranking.h"
+#include "server.h"
+
+const std::string KERNEL_PROGRAM_FILE = "kernel.cl";
+const std::string DEFAULT_SOCKET_PATH = "/tmp/opencl_example.sock";
+const std::string RANKING_FILE = "device_ranking.tsv";
+// Vector size the devices are ranked for, in the range of requests which get coalesced.
+const size_t RANKING_ELEMENTS = 1 << 16;
+
+ComputeServer *runningServer = nullptr;
+
+void stopServer(int) {
+    if (runningServer != nullptr) {
+        runningServer->stop();
+    }
+}
+
+/**
+ * Initialises OpenCL once and serves kernel requests on a Unix domain socket until
+ * SIGINT or SIGTERM. Small requests are coalesced for up to the window, 0 turns that off.
+ * Usage: opencl_daemon [socket path] [window us] [max requests per batch] [deadline us]
+ **/
+int main(int argc, char *argv[]) {
+    const std::string socketPath = argc > 1 ? argv[1] : DEFAULT_SOCKET_PATH;
+    CoalescingConfig coalescing;
+    if (argc > 2) {
+        coalescing.window = std::chrono::microseconds(std::strtoll(argv[2], nullptr, 10));
+    }
+    if (argc > 3) {
+        coalescing.maxRequests = std::max(1ull, std::strtoull(argv[3], nullptr, 10));
+    }
+    if (argc > 4) {
+        coalescing.deadline = std::chrono::microseconds(std::strtoll(argv[4], nullptr, 10));
+    }
+    coalescing.enabled = coalescing.window.count() > 0;
+
+    // Serve from the device fastest at typical request sizes across all platforms.
+    auto ranking = rankDevices(RANKING_ELEMENTS, CL_DEVICE_TYPE_ALL, RANKING_FILE);
+    printRanking(ranking, std::cout);
+    if (ranking.empty()) {
+        std::cerr << "No devices found!" << std::endl;
+        exit(1);
+    }
+
+    cl::Device device = ranking.front().device;
+    cl::Context context(device);
+    cl::Program program = buildProgram(context, device, KERNEL_PROGRAM_FILE);
+    std::cout << "Using device " << device.getInfo<CL_DEVICE_NAME>() << std::endl;
+
+    ComputeServer server(context, device, program, socketPath);
+    server.registerKernel(protocol::Operation::Vadd, "vadd", "vadd_segmented", 2);
+    server.setCoalescing(coalescing);
+
+    runningServer = &server;
+    std::signal(SIGINT, stopServer);
+    std::signal(SIGTERM, stopServer);
+    return server.run() ? 0 : 1;
+}
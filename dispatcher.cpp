@@ -0,0 +1,207 @@
+#include "dispatcher.h"
+#include "host.h"
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+
+namespace {
+
+    const std::string OPERATION = "vadd";
+    const Route ROUTES[] = {Route::Host, Route::Device, Route::CoExecution};
+    // Runs of every route before the models decide alone.
+    const double EXPLORATION_SAMPLES = 3;
+
+    Route routeFromName(const std::string &name) {
+        for (auto route: ROUTES) {
+            if (routeName(route) == name) {
+                return route;
+            }
+        }
+        return Route::Host;
+    }
+}
+
+std::string routeName(Route route) {
+    switch (route) {
+        case Route::Host:
+            return "host";
+        case Route::Device:
+            return "device";
+        case Route::CoExecution:
+            return "co-execution";
+    }
+    return "";
+}
+
+void LatencyModel::add(double bytes, double seconds) {
+    samples++;
+    sumBytes += bytes;
+    sumSeconds += seconds;
+    sumBytesSquared += bytes * bytes;
+    sumBytesSeconds += bytes * seconds;
+}
+
+bool LatencyModel::isFitted() const {
+    return samples >= 2 && samples * sumBytesSquared - sumBytes * sumBytes > 0;
+}
+
+double LatencyModel::secondsPerByte() const {
+    if (!isFitted()) {
+        // Runs of a single size only tell the average rate.
+        return sumBytes > 0 ? sumSeconds / sumBytes : 0;
+    }
+    double slope = (samples * sumBytesSeconds - sumBytes * sumSeconds) /
+                   (samples * sumBytesSquared - sumBytes * sumBytes);
+    return std::max(0.0, slope);
+}
+
+double LatencyModel::fixedSeconds() const {
+    if (!isFitted()) {
+        return 0;
+    }
+    return std::max(0.0, (sumSeconds - secondsPerByte() * sumBytes) / samples);
+}
+
+double LatencyModel::predict(double bytes) const {
+    return fixedSeconds() + secondsPerByte() * bytes;
+}
+
+Dispatcher::Dispatcher(const cl::Context &context, const cl::Device &device, const cl::Program &program,
+                       unsigned hostThreads, std::string modelFile)
+        : context(context), queue(context, device), kernel(program, "vadd"),
+          coExecutor(context, device, program, hostThreads), hostThreads(hostThreads),
+          deviceName(device.getInfo<CL_DEVICE_NAME>()), modelFile(std::move(modelFile)) {
+    load();
+}
+
+Dispatcher::~Dispatcher() {
+    save();
+}
+
+const Decision &Dispatcher::lastDecision() const {
+    return decision;
+}
+
+const LatencyModel &Dispatcher::model(Route route) const {
+    return models.at(route);
+}
+
+Route Dispatcher::choose(size_t bytes, double &predictedSeconds) const {
+    predictedSeconds = 0;
+    for (auto route: ROUTES) {
+        if (models.at(route).samples < EXPLORATION_SAMPLES) {
+            return route;
+        }
+    }
+
+    Route best = Route::Host;
+    predictedSeconds = models.at(best).predict(bytes);
+    for (auto route: ROUTES) {
+        if (double predicted = models.at(route).predict(bytes); predicted < predictedSeconds) {
+            best = route;
+            predictedSeconds = predicted;
+        }
+    }
+    return best;
+}
+
+Route Dispatcher::vadd(float a, std::span<const float> x, std::span<const float> y,
+                       std::span<float> result) {
+    const size_t bytes = 3 * sizeof(float) * x.size();
+    double predictedSeconds;
+    Route route = choose(bytes, predictedSeconds);
+
+    auto start_time = std::chrono::high_resolution_clock::now();
+    switch (route) {
+        case Route::Host:
+            vaddOnHostThreads(a, x.data(), y.data(), result.data(), x.size(), hostThreads);
+            break;
+        case Route::Device:
+            runOnDevice(a, x, y, result);
+            break;
+        case Route::CoExecution:
+            coExecutor.vadd(a, x, y, result);
+            break;
+    }
+    std::chrono::duration<double> time = std::chrono::high_resolution_clock::now() - start_time;
+
+    models[route].add(bytes, time.count());
+    decision = {route, bytes, predictedSeconds, time.count()};
+    return route;
+}
+
+void Dispatcher::runOnDevice(float a, std::span<const float> x, std::span<const float> y,
+                             std::span<float> result) {
+    const size_t bytes = sizeof(float) * x.size();
+    cl::Buffer aBuf(context, CL_MEM_READ_ONLY | CL_MEM_USE_HOST_PTR, bytes, const_cast<float *>(x.data()));
+    cl::Buffer bBuf(context, CL_MEM_READ_ONLY | CL_MEM_USE_HOST_PTR, bytes, const_cast<float *>(y.data()));
+    cl::Buffer cBuf(context, CL_MEM_WRITE_ONLY, bytes);
+    kernel.setArg(0, a);
+    kernel.setArg(1, aBuf);
+    kernel.setArg(2, bBuf);
+    kernel.setArg(3, cBuf);
+    queue.enqueueNDRangeKernel(kernel, cl::NullRange, cl::NDRange(x.size()));
+    queue.enqueueReadBuffer(cBuf, CL_TRUE, 0, bytes, result.data());
+}
+
+void Dispatcher::printModels(std::ostream &out) const {
+    out << "Dispatcher latency models for " << OPERATION << " on " << deviceName << ":\n";
+    for (auto route: ROUTES) {
+        const auto &model = models.at(route);
+        out << "  " << std::left << std::setw(13) << routeName(route) << std::right << std::setw(6) << model.samples
+            << " runs, fixed " << std::setprecision(2) << std::fixed << model.fixedSeconds() * 1e6 << " us + "
+            << std::setprecision(4) << model.secondsPerByte() * 1e9 << " ns/byte\n";
+    }
+}
+
+// The file has one tab separated line per operation, route and device:
+// operation, route, samples, sumBytes, sumSeconds, sumBytesSquared, sumBytesSeconds, device name.
+void Dispatcher::load() {
+    for (auto route: ROUTES) {
+        models[route] = {};
+    }
+
+    std::ifstream file(modelFile);
+    std::string line;
+    while (std::getline(file, line)) {
+        std::istringstream fields(line);
+        std::string operation, route, device;
+        LatencyModel model;
+        std::getline(fields, operation, '\t');
+        std::getline(fields, route, '\t');
+        fields >> model.samples >> model.sumBytes >> model.sumSeconds >> model.sumBytesSquared
+               >> model.sumBytesSeconds;
+        fields.ignore();
+        std::getline(fields, device);
+        if (fields && operation == OPERATION && device == deviceName) {
+            models[routeFromName(route)] = model;
+        }
+    }
+}
+
+void Dispatcher::save() const {
+    // Keep the models of other operations and devices sharing the file.
+    std::vector<std::string> lines;
+    std::ifstream existing(modelFile);
+    for (std::string line; std::getline(existing, line);) {
+        if (!line.starts_with(OPERATION + "\t") || !line.ends_with("\t" + deviceName)) {
+            lines.push_back(line);
+        }
+    }
+    existing.close();
+
+    std::ofstream file(modelFile);
+    for (const auto &line: lines) {
+        file << line << "\n";
+    }
+    file << std::setprecision(17);
+    for (auto route: ROUTES) {
+        const auto &model = models.at(route);
+        file << OPERATION << "\t" << routeName(route) << "\t" << model.samples << "\t" << model.sumBytes << "\t"
+             << model.sumSeconds << "\t" << model.sumBytesSquared << "\t" << model.sumBytesSeconds << "\t"
+             << deviceName << "\n";
+    }
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+#include "coexec.h"
+
+#include <CL/opencl.hpp>
+#include <map>
+#include <ostream>
+#include <span>
+#include <string>
+#include <vector>
+
+enum class Route {
+    Host,       // vaddOnHostThreads
+    Device,     // a single kernel launch on the device
+    CoExecution // CoExecutor splitting between both
+};
+
+std::string routeName(Route route);
+
+// Latency t = fixed + perByte * bytes, least squares fitted from running sums of observed runs.
+struct LatencyModel {
+    double samples = 0;
+    double sumBytes = 0;
+    double sumSeconds = 0;
+    double sumBytesSquared = 0;
+    double sumBytesSeconds = 0;
+
+    void add(double bytes, double seconds);
+
+    // True once runs of at least two different sizes have been observed.
+    bool isFitted() const;
+
+    double fixedSeconds() const;
+
+    double secondsPerByte() const;
+
+    double predict(double bytes) const;
+};
+
+struct Decision {
+    Route route;
+    size_t bytes;
+    double predictedSeconds;    // 0 while the route is still being explored
+    double measuredSeconds;
+};
+
+/**
+ * Routes each vadd to the host, the device or co-execution, whichever the latency models
+ * fitted from earlier runs on this device predict to finish first. Every route is tried a few
+ * times before the models are trusted. Models are loaded from and saved to modelFile.
+ **/
+class Dispatcher {
+public:
+    Dispatcher(const cl::Context &context, const cl::Device &device, const cl::Program &program,
+               unsigned hostThreads, std::string modelFile);
+
+    ~Dispatcher();
+
+    Route vadd(float a, std::span<const float> x, std::span<const float> y, std::span<float> result);
+
+    const Decision &lastDecision() const;
+
+    const LatencyModel &model(Route route) const;
+
+    // One line per route with its sample count and fitted parameters.
+    void printModels(std::ostream &out) const;
+
+    void save() const;
+
+private:
+    Route choose(size_t bytes, double &predictedSeconds) const;
+
+    void runOnDevice(float a, std::span<const float> x, std::span<const float> y, std::span<float> result);
+
+    void load();
+
+    cl::Context context;
+    cl::CommandQueue queue;
+    cl::Kernel kernel;
+    CoExecutor coExecutor;
+    unsigned hostThreads;
+    std::string deviceName;
+    std::string modelFile;
+    std::map<Route, LatencyModel> models;
+    Decision decision{};
+};
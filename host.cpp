@@ -0,0 +1,91 @@
+#include "host.h"
+
+#include <algorithm>
+#include <bit>
+#include <thread>
+#include <vector>
+
+namespace {
+
+    // Elements of x and y swept over all scalars before moving on, small enough to stay in the L1 cache.
+    const size_t SWEEP_BLOCK = 2048;
+
+    void vaddSeparate(float a, const float *__restrict x, const float *__restrict y, float *__restrict c, size_t n) {
+        for (size_t i = 0; i < n; i++) {
+            c[i] = a * x[i] + y[i] * x[i];
+        }
+    }
+
+    void vaddOverX(float a, float *__restrict x, const float *__restrict y, size_t n) {
+        for (size_t i = 0; i < n; i++) {
+            x[i] = a * x[i] + y[i] * x[i];
+        }
+    }
+
+    void vaddOverY(float a, const float *__restrict x, float *__restrict y, size_t n) {
+        for (size_t i = 0; i < n; i++) {
+            y[i] = a * x[i] + y[i] * x[i];
+        }
+    }
+}
+
+void vaddOnHost(float a, const float *x, const float *y, float *c, size_t n) {
+    // __restrict promises the arrays are distinct, so each aliasing case gets a loop of its own.
+    if (c == x && c == y) {
+        for (size_t i = 0; i < n; i++) {
+            c[i] = a * c[i] + c[i] * c[i];
+        }
+    } else if (c == x) {
+        vaddOverX(a, c, y, n);
+    } else if (c == y) {
+        vaddOverY(a, x, c, n);
+    } else {
+        vaddSeparate(a, x, y, c, n);
+    }
+}
+
+void vaddOnHostThreads(float a, const float *x, const float *y, float *c, size_t n, unsigned threads) {
+    threads = std::max(1u, threads);
+    // Slices are multiples of 16 floats so no two threads write the same cache line.
+    const size_t slice = std::max<size_t>(16, ((n + threads - 1) / threads + 15) / 16 * 16);
+
+    std::vector<std::thread> workers;
+    for (size_t begin = slice; begin < n; begin += slice) {
+        const size_t count = std::min(slice, n - begin);
+        workers.emplace_back(vaddOnHost, a, x + begin, y + begin, c + begin, count);
+    }
+    vaddOnHost(a, x, y, c, std::min(slice, n));
+    for (auto &worker: workers) {
+        worker.join();
+    }
+}
+
+void vaddOnHostIndexed(float a, const float *x, const float *y, float *c, const uint32_t *indices, size_t count) {
+    for (size_t k = 0; k < count; k++) {
+        const uint32_t i = indices[k];
+        c[i] = a * x[i] + y[i] * x[i];
+    }
+}
+
+void vaddOnHostMasked(float a, const float *x, const float *y, float *c, const uint32_t *mask, size_t n) {
+    for (size_t word = 0; word < (n + 31) / 32; word++) {
+        // Bits past n are ignored, unlike in vadd_masked.
+        uint32_t bits = mask[word];
+        if (word == n / 32) {
+            bits &= (1u << n % 32) - 1;
+        }
+        for (; bits != 0; bits &= bits - 1) {
+            const size_t i = word * 32 + std::countr_zero(bits);
+            c[i] = a * x[i] + y[i] * x[i];
+        }
+    }
+}
+
+void vaddOnHostSweep(const float *scalars, size_t count, const float *x, const float *y, float *c, size_t n) {
+    for (size_t begin = 0; begin < n; begin += SWEEP_BLOCK) {
+        const size_t blockCount = std::min(SWEEP_BLOCK, n - begin);
+        for (size_t k = 0; k < count; k++) {
+            vaddSeparate(scalars[k], x + begin, y + begin, c + k * n + begin, blockCount);
+        }
+    }
+}
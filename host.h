@@ -0,0 +1,22 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * c[i] = a * x[i] + y[i] * x[i] for i in [0, n), written so the compiler vectorises it. c may be
+ * x or y to compute in place, but must not partly overlap them.
+ **/
+void vaddOnHost(float a, const float *x, const float *y, float *c, size_t n);
+
+// vaddOnHost split into contiguous slices over `threads` threads, the caller's included.
+void vaddOnHostThreads(float a, const float *x, const float *y, float *c, size_t n, unsigned threads);
+
+// vaddOnHost for the `count` elements listed in indices only, the others keep their value in c.
+void vaddOnHostIndexed(float a, const float *x, const float *y, float *c, const uint32_t *indices, size_t count);
+
+// vaddOnHost for the elements of [0, n) whose bit is set in mask, bit i % 32 of mask[i / 32].
+void vaddOnHostMasked(float a, const float *x, const float *y, float *c, const uint32_t *mask, size_t n);
+
+// vaddOnHost for each of the `count` scalars, into row k of c holding count rows of n floats.
+void vaddOnHostSweep(const float *scalars, size_t count, const float *x, const float *y, float *c, size_t n);
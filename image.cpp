@@ -0,0 +1,152 @@
+#include "image.h"
+#include "host.h"
+#include "program.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <sstream>
+
+namespace {
+
+    const std::string KERNEL_PROGRAM_FILE = "kernel.cl";
+    const int REPEATS = 10;
+    // Width over height of the grids.
+    const double ASPECTS[] = {16, 4, 1, 0.25, 0.0625};
+    const size_t MAX_TILE = 16;
+    const float SCALAR = 2.0f;
+    const float TOLERANCE = 1e-2;
+
+    // Best kernel execution time of REPEATS launches according to event profiling. Exits when a launch fails.
+    double bestKernelSeconds(const cl::CommandQueue &queue, const cl::Kernel &kernel, const std::string &name,
+                             const cl::NDRange &global, const cl::NDRange &local) {
+        cl_ulong best = std::numeric_limits<cl_ulong>::max();
+        for (int i = 0; i < REPEATS; i++) {
+            cl::Event event;
+            const cl_int error = queue.enqueueNDRangeKernel(kernel, cl::NullRange, global, local, nullptr, &event);
+            if (error != CL_SUCCESS) {
+                std::cerr << name << " failed with OpenCL error " << error << std::endl;
+                std::exit(1);
+            }
+            event.wait();
+            best = std::min(best, event.getProfilingInfo<CL_PROFILING_COMMAND_END>() -
+                                  event.getProfilingInfo<CL_PROFILING_COMMAND_START>());
+        }
+        return static_cast<double>(best) * 1e-9;
+    }
+
+    // Largest power of two side, up to MAX_TILE, whose square tile both kernels accept.
+    size_t tileSide(const cl::Device &device, const cl::Kernel &grid, const cl::Kernel &image) {
+        const size_t limit = std::min(grid.getWorkGroupInfo<CL_KERNEL_WORK_GROUP_SIZE>(device),
+                                      image.getWorkGroupInfo<CL_KERNEL_WORK_GROUP_SIZE>(device));
+        size_t side = 1;
+        while (side < MAX_TILE && 4 * side * side <= limit) {
+            side *= 2;
+        }
+        return side;
+    }
+
+    size_t roundUp(size_t value, size_t multiple) {
+        return (value + multiple - 1) / multiple * multiple;
+    }
+}
+
+void printImageReport(const std::vector<cl::Device> &devices, size_t elements) {
+    for (const auto &device: devices) {
+        if (!device.getInfo<CL_DEVICE_IMAGE_SUPPORT>()) {
+            std::cout << device.getInfo<CL_DEVICE_NAME>() << " has no image support, skipping the image report\n";
+            continue;
+        }
+        const size_t maxWidth = device.getInfo<CL_DEVICE_IMAGE2D_MAX_WIDTH>();
+        const size_t maxHeight = device.getInfo<CL_DEVICE_IMAGE2D_MAX_HEIGHT>();
+
+        // CL_R is not among the formats OpenCL 1.2 devices must support.
+        cl::Context context(device);
+        const cl::ImageFormat format(CL_R, CL_FLOAT);
+        std::vector<cl::ImageFormat> formats;
+        context.getSupportedImageFormats(CL_MEM_READ_ONLY, CL_MEM_OBJECT_IMAGE2D, &formats);
+        if (std::none_of(formats.begin(), formats.end(), [&](const cl::ImageFormat &supported) {
+            return supported.image_channel_order == format.image_channel_order &&
+                   supported.image_channel_data_type == format.image_channel_data_type;
+        })) {
+            std::cout << device.getInfo<CL_DEVICE_NAME>() << " has no CL_R/CL_FLOAT images, skipping the image "
+                      << "report\n";
+            continue;
+        }
+        cl::Program program = buildProgram(context, device, KERNEL_PROGRAM_FILE);
+        cl::CommandQueue queue(context, device, CL_QUEUE_PROFILING_ENABLE);
+        cl::Kernel grid(program, "vadd_grid"), image(program, "vadd_image");
+        const size_t tile = tileSide(device, grid, image);
+
+        std::cout << "2D vadd on " << device.getInfo<CL_DEVICE_NAME>() << " in " << tile << "x" << tile
+                  << " tiles, buffers against images (us per launch):\n"
+                  << std::setw(16) << "grid" << std::setw(16) << "buffer" << std::setw(16) << "image"
+                  << std::setw(16) << "buffer columns" << std::setw(16) << "image columns" << "\n";
+        for (double aspect: ASPECTS) {
+            const size_t width = std::clamp<size_t>(std::lround(std::sqrt(elements * aspect)), 1, maxWidth);
+            const size_t height = std::clamp<size_t>(elements / width, 1, maxHeight);
+            const size_t count = width * height;
+            std::vector<float> x(count), y(count), expected(count), c(count);
+            for (size_t i = 0; i < count; i++) {
+                x[i] = static_cast<float>(i % 100);
+                y[i] = static_cast<float>(i % 7);
+            }
+            vaddOnHost(SCALAR, x.data(), y.data(), expected.data(), count);
+
+            const size_t bytes = sizeof(float) * count;
+            cl::Buffer xBuf(context, CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR, bytes, x.data());
+            cl::Buffer yBuf(context, CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR, bytes, y.data());
+            cl_int xError = CL_SUCCESS, yError = CL_SUCCESS;
+            cl::Image2D xImage(context, CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR, format, width, height, 0, x.data(),
+                               &xError);
+            cl::Image2D yImage(context, CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR, format, width, height, 0, y.data(),
+                               &yError);
+            if (xError != CL_SUCCESS || yError != CL_SUCCESS) {
+                std::cout << "Cannot create " << width << "x" << height << " images on "
+                          << device.getInfo<CL_DEVICE_NAME>() << ", OpenCL error "
+                          << (xError != CL_SUCCESS ? xError : yError) << ", skipping the rest of the image report\n";
+                break;
+            }
+            cl::Buffer cBuf(context, CL_MEM_WRITE_ONLY, bytes);
+            grid.setArg(1, xBuf);
+            grid.setArg(2, yBuf);
+            image.setArg(1, xImage);
+            image.setArg(2, yImage);
+
+            std::ostringstream shape;
+            shape << width << "x" << height;
+            std::cout << std::setw(16) << shape.str() << std::fixed << std::setprecision(1);
+            for (cl_uint transposed: {0u, 1u}) {
+                // Transposed, dimension 0 runs over rows, so the NDRange swaps its extents.
+                const cl::NDRange global = transposed ? cl::NDRange(roundUp(height, tile), roundUp(width, tile))
+                                                      : cl::NDRange(roundUp(width, tile), roundUp(height, tile));
+                for (cl::Kernel *kernel: {&grid, &image}) {
+                    const std::string name = kernel == &grid ? "vadd_grid" : "vadd_image";
+                    kernel->setArg(0, SCALAR);
+                    kernel->setArg(3, cBuf);
+                    kernel->setArg(4, static_cast<cl_uint>(width));
+                    kernel->setArg(5, static_cast<cl_uint>(height));
+                    kernel->setArg(6, transposed);
+                    // NaN everywhere, so elements the kernel did not write fail the check below.
+                    queue.enqueueFillBuffer(cBuf, std::numeric_limits<float>::quiet_NaN(), 0, bytes);
+                    const double seconds = bestKernelSeconds(queue, *kernel, name, global, cl::NDRange(tile, tile));
+
+                    queue.enqueueReadBuffer(cBuf, CL_TRUE, 0, bytes, c.data());
+                    for (size_t i = 0; i < count; i++) {
+                        if (!(std::fabs(c[i] - expected[i]) < TOLERANCE)) {
+                            std::cerr << name << " differs from the host at element " << i << " of the "
+                                      << shape.str() << " grid" << std::endl;
+                            std::exit(1);
+                        }
+                    }
+                    std::cout << std::setw(16) << seconds * 1e6;
+                }
+            }
+            std::cout << "\n";
+        }
+        std::cout << std::flush;
+    }
+}
@@ -0,0 +1,13 @@
+#pragma once
+
+#include <CL/opencl.hpp>
+#include <vector>
+
+/**
+ * Times vadd over 2D grids of about `elements` floats in several shapes, from 16 times wider
+ * than tall to 16 times taller than wide, with x and y in buffers (vadd_grid) against CL_R /
+ * CL_FLOAT images (vadd_image). Each runs over square tiles of work-items, walking rows and,
+ * transposed, columns, where buffer reads are strided and image reads can use 2D locality.
+ * Devices without image support are skipped.
+ **/
+void printImageReport(const std::vector<cl::Device> &devices, size_t elements);
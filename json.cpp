@@ -0,0 +1,217 @@
+#include "json.h"
+
+#include <cstdlib>
+
+namespace {
+
+    // Recursive descent over the text, stopping at the first error.
+    class Parser {
+    public:
+        explicit Parser(const std::string &text) : text(text) {}
+
+        bool parseDocument(JsonValue &value, std::string &error) {
+            if (parseValue(value, 0)) {
+                skipSpace();
+                if (position == text.size()) {
+                    return true;
+                }
+                fail("unexpected trailing characters");
+            }
+            error = message + " at offset " + std::to_string(position);
+            return false;
+        }
+
+    private:
+        // Deeper documents are not results files, the limit keeps the recursion off the stack's end.
+        static const int MAX_DEPTH = 64;
+
+        bool fail(const std::string &what) {
+            message = what;
+            return false;
+        }
+
+        void skipSpace() {
+            while (position < text.size() &&
+                   (text[position] == ' ' || text[position] == '\t' || text[position] == '\n' ||
+                    text[position] == '\r')) {
+                position++;
+            }
+        }
+
+        bool consume(const std::string &word) {
+            if (text.compare(position, word.size(), word) != 0) {
+                return false;
+            }
+            position += word.size();
+            return true;
+        }
+
+        bool parseValue(JsonValue &value, int depth) {
+            if (depth > MAX_DEPTH) {
+                return fail("nested too deeply");
+            }
+            skipSpace();
+            if (position == text.size()) {
+                return fail("unexpected end");
+            }
+            switch (text[position]) {
+                case '{':
+                    return parseObject(value, depth);
+                case '[':
+                    return parseArray(value, depth);
+                case '"':
+                    value.type = JsonValue::Type::String;
+                    return parseString(value.string);
+                case 't':
+                case 'f':
+                    value.type = JsonValue::Type::Boolean;
+                    value.boolean = text[position] == 't';
+                    return consume(value.boolean ? "true" : "false") || fail("invalid literal");
+                case 'n':
+                    value.type = JsonValue::Type::Null;
+                    return consume("null") || fail("invalid literal");
+                default:
+                    return parseNumber(value);
+            }
+        }
+
+        bool parseNumber(JsonValue &value) {
+            const char *begin = text.c_str() + position;
+            char *end = nullptr;
+            value.type = JsonValue::Type::Number;
+            value.number = std::strtod(begin, &end);
+            if (end == begin) {
+                return fail("invalid value");
+            }
+            position += end - begin;
+            return true;
+        }
+
+        bool parseString(std::string &out) {
+            position++;
+            while (position < text.size() && text[position] != '"') {
+                char c = text[position++];
+                if (c != '\\') {
+                    out += c;
+                    continue;
+                }
+                if (position == text.size()) {
+                    break;
+                }
+                char escaped = text[position++];
+                switch (escaped) {
+                    case 'b':
+                        out += '\b';
+                        break;
+                    case 'f':
+                        out += '\f';
+                        break;
+                    case 'n':
+                        out += '\n';
+                        break;
+                    case 'r':
+                        out += '\r';
+                        break;
+                    case 't':
+                        out += '\t';
+                        break;
+                    case 'u': {
+                        if (position + 4 > text.size()) {
+                            return fail("truncated escape");
+                        }
+                        // Names and device strings are ASCII in practice, others become UTF-8 of the BMP.
+                        unsigned code = std::strtoul(text.substr(position, 4).c_str(), nullptr, 16);
+                        position += 4;
+                        if (code < 0x80) {
+                            out += static_cast<char>(code);
+                        } else if (code < 0x800) {
+                            out += static_cast<char>(0xc0 | code >> 6);
+                            out += static_cast<char>(0x80 | (code & 0x3f));
+                        } else {
+                            out += static_cast<char>(0xe0 | code >> 12);
+                            out += static_cast<char>(0x80 | (code >> 6 & 0x3f));
+                            out += static_cast<char>(0x80 | (code & 0x3f));
+                        }
+                        break;
+                    }
+                    default:
+                        out += escaped;
+                }
+            }
+            if (position == text.size()) {
+                return fail("unterminated string");
+            }
+            position++;
+            return true;
+        }
+
+        bool parseArray(JsonValue &value, int depth) {
+            value.type = JsonValue::Type::Array;
+            position++;
+            skipSpace();
+            if (consume("]")) {
+                return true;
+            }
+            do {
+                value.array.emplace_back();
+                if (!parseValue(value.array.back(), depth + 1)) {
+                    return false;
+                }
+                skipSpace();
+            } while (consume(","));
+            return consume("]") || fail("expected , or ]");
+        }
+
+        bool parseObject(JsonValue &value, int depth) {
+            value.type = JsonValue::Type::Object;
+            position++;
+            skipSpace();
+            if (consume("}")) {
+                return true;
+            }
+            do {
+                skipSpace();
+                std::string key;
+                if (position == text.size() || text[position] != '"') {
+                    return fail("expected a member name");
+                }
+                if (!parseString(key)) {
+                    return false;
+                }
+                skipSpace();
+                if (!consume(":")) {
+                    return fail("expected :");
+                }
+                value.members.emplace_back(std::move(key), JsonValue());
+                if (!parseValue(value.members.back().second, depth + 1)) {
+                    return false;
+                }
+                skipSpace();
+            } while (consume(","));
+            return consume("}") || fail("expected , or }");
+        }
+
+        const std::string &text;
+        size_t position = 0;
+        std::string message;
+    };
+}
+
+const JsonValue *JsonValue::find(const std::string &key) const {
+    for (const auto &[name, value]: members) {
+        if (name == key) {
+            return &value;
+        }
+    }
+    return nullptr;
+}
+
+std::string JsonValue::stringOr(const std::string &key, const std::string &fallback) const {
+    const JsonValue *value = find(key);
+    return value != nullptr && value->type == Type::String ? value->string : fallback;
+}
+
+bool parseJson(const std::string &text, JsonValue &value, std::string &error) {
+    value = JsonValue();
+    return Parser(text).parseDocument(value, error);
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <string>
+#include <utility>
+#include <vector>
+
+/**
+ * A parsed JSON document, just enough to read the result files of opencl_example --format json
+ * and of Google Benchmark. Numbers are doubles, objects keep their members in order.
+ **/
+struct JsonValue {
+    enum class Type {
+        Null,
+        Boolean,
+        Number,
+        String,
+        Array,
+        Object
+    };
+
+    Type type = Type::Null;
+    bool boolean = false;
+    double number = 0;
+    std::string string;
+    std::vector<JsonValue> array;
+    std::vector<std::pair<std::string, JsonValue>> members;
+
+    // The member named key of an object, nullptr for other types or when missing.
+    const JsonValue *find(const std::string &key) const;
+
+    // The string member named key, or fallback.
+    std::string stringOr(const std::string &key, const std::string &fallback) const;
+};
+
+// Parses text into value. On malformed input returns false with error saying what and where.
+bool parseJson(const std::string &text, JsonValue &value, std::string &error);
@@ -1,9 +1,212 @@
 /**
  * This kernel function sums two arrays of integers and returns its result
- * through a third array.
+ * through a third array. c may be the buffer of x or y to compute in place.
  **/
 
  __kernel void vadd(float a, __global float* x, __global float* y, __global float* c){
      int index = get_global_id(0);
      c[index] = a * x[index] + y[index] * x[index];
- }
\ No newline at end of file
+ }
+
+/**
+ * vadd over several requests packed back to back, each with its own scalar. Segment s
+ * covers elements starts[s] up to starts[s + 1], starts holds segments + 1 entries.
+ **/
+ __kernel void vadd_segmented(__global const float* scalars, __global const uint* starts, uint segments,
+                              __global const float* x, __global const float* y, __global float* c){
+     const uint index = get_global_id(0);
+     uint low = 0;
+     uint high = segments;
+     while (high - low > 1) {
+         const uint middle = (low + high) / 2;
+         if (starts[middle] <= index) {
+             low = middle;
+         } else {
+             high = middle;
+         }
+     }
+     c[index] = scalars[low] * x[index] + y[index] * x[index];
+ }
+
+#ifndef VADD_UNROLL
+#define VADD_UNROLL 4
+#endif
+
+/**
+ * Grid-stride variant of vadd. Each work-item computes VADD_UNROLL elements per pass,
+ * striding by the global size, so a launch sized to the device covers any n. c may be the
+ * buffer of x or y, each element is read by the work-item writing it, before it writes it.
+ **/
+ __kernel void vadd_stride(float a, __global const float* x, __global const float* y, __global float* c, uint n){
+     const uint stride = get_global_size(0);
+     uint index = get_global_id(0);
+     for (; index + (VADD_UNROLL - 1) * stride < n; index += VADD_UNROLL * stride) {
+         for (int k = 0; k < VADD_UNROLL; k++) {
+             const uint i = index + k * stride;
+             c[i] = a * x[i] + y[i] * x[i];
+         }
+     }
+     for (; index < n; index += stride) {
+         c[index] = a * x[index] + y[index] * x[index];
+     }
+ }
+
+/**
+ * vadd for `count` scalars in one pass, loading each element of x and y once: row k of c, which
+ * holds count rows of n floats, gets scalars[k] * x + y * x. The scalars are read from constant
+ * memory, the same one by all work-items at a time. Offsets into c are 64 bit, count * n may
+ * exceed a uint.
+ **/
+ __kernel void vadd_sweep(__constant float* scalars, uint count, __global const float* x, __global const float* y,
+                          __global float* c, uint n){
+     const uint index = get_global_id(0);
+     if (index >= n) {
+         return;
+     }
+     const float xi = x[index];
+     const float yi = y[index];
+     for (uint k = 0; k < count; k++) {
+         c[(ulong) k * n + index] = scalars[k] * xi + yi * xi;
+     }
+ }
+
+/**
+ * vadd for the elements listed in indices only, one work-item per entry. Elements not listed
+ * keep their value in c, listing one twice is harmless.
+ **/
+ __kernel void vadd_indexed(float a, __global const float* x, __global const float* y, __global float* c,
+                            __global const uint* indices, uint count){
+     const uint k = get_global_id(0);
+     if (k < count) {
+         const uint i = indices[k];
+         c[i] = a * x[i] + y[i] * x[i];
+     }
+ }
+
+/**
+ * vadd for the elements whose bit is set in mask, bit i % 32 of mask[i / 32]. One work-item
+ * per mask word, so words without set bits cost a single load. Bits past the vectors must be 0.
+ **/
+ __kernel void vadd_masked(float a, __global const float* x, __global const float* y, __global float* c,
+                           __global const uint* mask, uint words){
+     const uint word = get_global_id(0);
+     if (word >= words) {
+         return;
+     }
+     for (uint bits = mask[word]; bits != 0; bits &= bits - 1) {
+         const uint i = word * 32 + 31 - clz(bits & -bits);
+         c[i] = a * x[i] + y[i] * x[i];
+     }
+ }
+
+/**
+ * Element of a width x height grid a 2D work-item computes. Transposed, neighbouring work-items
+ * of dimension 0 walk down a column, so row-major buffers are read with a stride of width.
+ **/
+int2 gridPosition(uint transposed){
+    const int column = get_global_id(transposed ? 1 : 0);
+    const int row = get_global_id(transposed ? 0 : 1);
+    return (int2)(column, row);
+}
+
+/**
+ * vadd over width x height grids stored row-major, with a 2D NDRange that may exceed the grid
+ * to cover it in whole tiles. The buffer counterpart of vadd_image.
+ **/
+ __kernel void vadd_grid(float a, __global const float* x, __global const float* y, __global float* c,
+                         uint width, uint height, uint transposed){
+     const int2 position = gridPosition(transposed);
+     if (position.x >= (int) width || position.y >= (int) height) {
+         return;
+     }
+     const uint i = position.y * width + position.x;
+     c[i] = a * x[i] + y[i] * x[i];
+ }
+
+// Devices without image support reject image types, they only get the buffer kernels.
+#ifdef __IMAGE_SUPPORT__
+
+__constant sampler_t GRID_SAMPLER = CLK_NORMALIZED_COORDS_FALSE | CLK_ADDRESS_CLAMP_TO_EDGE | CLK_FILTER_NEAREST;
+
+/**
+ * vadd_grid with x and y read from CL_R / CL_FLOAT images through the texture path.
+ **/
+ __kernel void vadd_image(float a, __read_only image2d_t x, __read_only image2d_t y, __global float* c,
+                          uint width, uint height, uint transposed){
+     const int2 position = gridPosition(transposed);
+     if (position.x >= (int) width || position.y >= (int) height) {
+         return;
+     }
+     const float xi = read_imagef(x, GRID_SAMPLER, position).x;
+     const float yi = read_imagef(y, GRID_SAMPLER, position).x;
+     c[position.y * width + position.x] = a * xi + yi * xi;
+ }
+
+#endif
+
+#ifndef QUANTIZATION_BLOCK
+#define QUANTIZATION_BLOCK 256
+#endif
+
+/**
+ * vadd over quantised inputs, see quantize.h: x[i] stands for x[i] * xBlocks[b].x + xBlocks[b].y
+ * with b the block of QUANTIZATION_BLOCK elements holding i, and y likewise. Work-items from n
+ * on do nothing, so the global size can be rounded up to whole work-groups.
+ **/
+#define VADD_QUANTIZED(name, type)                                                                        \
+ __kernel void name(float a, __global const type* x, __global const float2* xBlocks, __global const type* y, \
+                    __global const float2* yBlocks, __global float* c, uint n){                           \
+     const uint index = get_global_id(0);                                                                 \
+     if (index >= n) {                                                                                    \
+         return;                                                                                          \
+     }                                                                                                    \
+     const float2 xBlock = xBlocks[index / QUANTIZATION_BLOCK];                                           \
+     const float2 yBlock = yBlocks[index / QUANTIZATION_BLOCK];                                           \
+     const float xi = (float) x[index] * xBlock.x + xBlock.y;                                             \
+     const float yi = (float) y[index] * yBlock.x + yBlock.y;                                             \
+     c[index] = a * xi + yi * xi;                                                                         \
+ }
+
+VADD_QUANTIZED(vadd_int8, char)
+VADD_QUANTIZED(vadd_uint8, uchar)
+VADD_QUANTIZED(vadd_int16, short)
+
+#ifdef cl_khr_fp64
+#pragma OPENCL EXTENSION cl_khr_fp64 : enable
+typedef double reference_t;
+#else
+typedef float reference_t;
+#endif
+
+/**
+ * Checks c against vadd recomputed in double precision where the device supports it.
+ * Accumulates the number of elements off by tolerance or more in result[0], the first such
+ * index in result[1] and the bits of the largest absolute error in result[2].
+ **/
+ __kernel void vadd_verify(float a, __global const float* x, __global const float* y, __global const float* c,
+                           uint n, float tolerance, __global uint* result){
+     uint mismatches = 0;
+     uint firstIndex = UINT_MAX;
+     uint maxErrorBits = 0;
+     for (uint index = get_global_id(0); index < n; index += get_global_size(0)) {
+         const reference_t expected = (reference_t) a * x[index] + (reference_t) y[index] * x[index];
+         const float error = (float) fabs(expected - (reference_t) c[index]);
+         if (!(error < tolerance)) {
+             mismatches++;
+             firstIndex = min(firstIndex, index);
+         }
+         // Non-negative floats order the same as their bit patterns, NaN above all of them.
+         maxErrorBits = max(maxErrorBits, as_uint(error));
+     }
+     if (mismatches > 0) {
+         atomic_add(&result[0], mismatches);
+         atomic_min(&result[1], firstIndex);
+     }
+     atomic_max(&result[2], maxErrorBits);
+ }
+
+/**
+ * Does nothing, launched to measure the fixed cost of a kernel launch.
+ **/
+ __kernel void empty(){
+ }
@@ -0,0 +1,129 @@
+#include "launch.h"
+#include "program.h"
+
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+namespace {
+
+    const std::string KERNEL_PROGRAM_FILE = "kernel.cl";
+    const int LAUNCHES = 1000;
+    const int WARM_UP_LAUNCHES = 10;
+    const size_t TINY_VECTOR_SIZE = 1024;
+    const float SCALAR = 2.0f;
+    // Work-groups of vadd_stride resident per compute unit, enough to hide memory latency.
+    const int WAVES_PER_COMPUTE_UNIT = 8;
+
+    // Average seconds per launch of `launches` calls to launch, followed by finishing the queue.
+    double secondsPerLaunch(const cl::CommandQueue &queue, const std::function<void()> &launch) {
+        for (int i = 0; i < WARM_UP_LAUNCHES; i++) {
+            launch();
+        }
+        queue.finish();
+
+        auto start_time = std::chrono::high_resolution_clock::now();
+        for (int i = 0; i < LAUNCHES; i++) {
+            launch();
+        }
+        queue.finish();
+        std::chrono::duration<double> time = std::chrono::high_resolution_clock::now() - start_time;
+        return time.count() / LAUNCHES;
+    }
+
+    void printRow(const std::string &label, double seconds) {
+        std::cout << "  " << std::left << std::setw(36) << label << std::right << std::fixed << std::setprecision(2)
+                  << std::setw(10) << seconds * 1e6 << " us" << std::setprecision(0) << std::setw(12) << 1 / seconds
+                  << " launches/s\n";
+    }
+}
+
+void printLaunchOverheadReport(const std::vector<cl::Device> &devices) {
+    for (const auto &device: devices) {
+        cl::Context context(device);
+        cl::Program program = buildProgram(context, device, KERNEL_PROGRAM_FILE);
+        cl::CommandQueue queue(context, device);
+
+        cl::Kernel empty(program, "empty");
+        cl::Kernel vadd(program, "vadd");
+        cl::Buffer aBuf(context, CL_MEM_READ_ONLY, sizeof(float) * TINY_VECTOR_SIZE);
+        cl::Buffer bBuf(context, CL_MEM_READ_ONLY, sizeof(float) * TINY_VECTOR_SIZE);
+        cl::Buffer cBuf(context, CL_MEM_WRITE_ONLY, sizeof(float) * TINY_VECTOR_SIZE);
+        queue.enqueueFillBuffer(aBuf, 1.0f, 0, sizeof(float) * TINY_VECTOR_SIZE);
+        queue.enqueueFillBuffer(bBuf, 2.0f, 0, sizeof(float) * TINY_VECTOR_SIZE);
+        auto setVaddArgs = [&] {
+            vadd.setArg(0, SCALAR);
+            vadd.setArg(1, aBuf);
+            vadd.setArg(2, bBuf);
+            vadd.setArg(3, cBuf);
+        };
+        setVaddArgs();
+
+        auto enqueueEmpty = [&] { queue.enqueueNDRangeKernel(empty, cl::NullRange, cl::NDRange(1)); };
+        auto enqueueVadd = [&] { queue.enqueueNDRangeKernel(vadd, cl::NullRange, cl::NDRange(TINY_VECTOR_SIZE)); };
+        auto waitedOn = [&](const cl::Kernel &kernel, const cl::NDRange &global) {
+            return [&kernel, global, &queue] {
+                cl::Event computeEvent;
+                queue.enqueueNDRangeKernel(kernel, cl::NullRange, global, cl::NullRange, nullptr, &computeEvent);
+                computeEvent.wait();
+            };
+        };
+
+        std::cout << "Kernel launch overhead on " << device.getInfo<CL_DEVICE_NAME>() << ":\n";
+        printRow("empty, single launch + wait", secondsPerLaunch(queue, waitedOn(empty, cl::NDRange(1))));
+        printRow("vadd, single launch + wait",
+                 secondsPerLaunch(queue, waitedOn(vadd, cl::NDRange(TINY_VECTOR_SIZE))));
+        printRow("empty, back-to-back", secondsPerLaunch(queue, enqueueEmpty));
+        printRow("vadd, back-to-back, cached args", secondsPerLaunch(queue, enqueueVadd));
+        printRow("vadd, back-to-back, setArg per launch", secondsPerLaunch(queue, [&] {
+            setVaddArgs();
+            enqueueVadd();
+        }));
+        printRow("vadd, clFlush per launch", secondsPerLaunch(queue, [&] {
+            enqueueVadd();
+            queue.flush();
+        }));
+        printRow("vadd, clFinish per launch", secondsPerLaunch(queue, [&] {
+            enqueueVadd();
+            queue.finish();
+        }));
+        std::cout << std::flush;
+    }
+}
+
+size_t gridStrideGlobalSize(const cl::Kernel &kernel, const cl::Device &device, size_t size, size_t localSize,
+                            int unroll) {
+    size_t computeUnits = device.getInfo<CL_DEVICE_MAX_COMPUTE_UNITS>();
+    size_t wave = kernel.getWorkGroupInfo<CL_KERNEL_PREFERRED_WORK_GROUP_SIZE_MULTIPLE>(device);
+    localSize = localSize > 0 ? localSize : wave;
+    size_t groupSize = (std::max(wave, localSize) + localSize - 1) / localSize * localSize;
+    size_t global = computeUnits * WAVES_PER_COMPUTE_UNIT * groupSize;
+
+    // No point launching work-items which would have nothing to compute.
+    size_t needed = (size + unroll - 1) / unroll;
+    needed = (needed + localSize - 1) / localSize * localSize;
+    return std::min(global, needed);
+}
+
+cl::Buffer createInputBuffer(const cl::Context &context, const cl::CommandQueue &queue, MemoryMode mode, void *data,
+                             size_t bytes, cl_mem_flags access) {
+    switch (mode) {
+        case MemoryMode::CopyHostPtr:
+            return cl::Buffer(context, access | CL_MEM_COPY_HOST_PTR, bytes, data);
+        case MemoryMode::AllocHostPtr:
+        case MemoryMode::Device: {
+            cl_mem_flags flags = access;
+            if (mode == MemoryMode::AllocHostPtr) {
+                flags |= CL_MEM_ALLOC_HOST_PTR;
+            }
+            cl::Buffer buffer(context, flags, bytes);
+            queue.enqueueWriteBuffer(buffer, CL_TRUE, 0, bytes, data);
+            return buffer;
+        }
+        default:
+            return cl::Buffer(context, access | CL_MEM_USE_HOST_PTR, bytes, data);
+    }
+}
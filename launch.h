@@ -0,0 +1,24 @@
+#pragma once
+
+#include "options.h"
+
+#include <CL/opencl.hpp>
+#include <vector>
+
+/**
+ * Prints the cost of launching the empty kernel and a tiny vadd for each device: single
+ * launches waited on one by one, back-to-back enqueues, setArg per launch against cached
+ * arguments, and clFlush against clFinish after each enqueue, in us per launch and launches/s.
+ **/
+void printLaunchOverheadReport(const std::vector<cl::Device> &devices);
+
+// Sizes a vadd_stride launch over size elements to a few waves per compute unit instead of to the data.
+size_t gridStrideGlobalSize(const cl::Kernel &kernel, const cl::Device &device, size_t size, size_t localSize,
+                            int unroll);
+
+/**
+ * A kernel input holding bytes of data, placed as mode asks and written through queue where needed.
+ * Read-only unless access says otherwise, as for inputs the kernel overwrites with its result.
+ **/
+cl::Buffer createInputBuffer(const cl::Context &context, const cl::CommandQueue &queue, MemoryMode mode, void *data,
+                             size_t bytes, cl_mem_flags access = CL_MEM_READ_ONLY);
@@ -0,0 +1,128 @@
+#include <iostream>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "client.h"
+
+const std::string DEFAULT_SOCKET_PATH = "/tmp/opencl_example.sock";
+const float SCALAR = 2.0f;
+const float TOLERANCE = 1e-2;
+
+// Sends `requests` vadd requests of `size` elements over one connection and records their latencies.
+void generateLoad(const std::string &socketPath, int requests, size_t size, bool useSharedMemory,
+                  std::vector<double> &latencies, int &failures) {
+    ComputeClient client(socketPath);
+    std::vector<float> xCopied(size), yCopied(size), resultCopied;
+    float *x = xCopied.data(), *y = yCopied.data(), *result = nullptr;
+    if (useSharedMemory) {
+        // Three page-aligned arrays, each rounded up to whole pages.
+        if (client.attachSharedMemory(3 * (sizeof(float) * size + 4096)) != protocol::Status::Ok) {
+            std::cerr << "Cannot attach shared memory" << std::endl;
+            std::exit(1);
+        }
+        x = client.allocateShared(size);
+        y = client.allocateShared(size);
+        result = client.allocateShared(size);
+    }
+    for (size_t i = 0; i < size; i++) {
+        x[i] = static_cast<float>(i % 100);
+        y[i] = static_cast<float>(i % 7);
+    }
+
+    for (int i = 0; i < requests; i++) {
+        auto start_time = std::chrono::high_resolution_clock::now();
+        auto status = useSharedMemory ? client.vaddShared(SCALAR, x, y, result, size)
+                                      : client.vadd(SCALAR, xCopied, yCopied, resultCopied);
+        std::chrono::duration<double> time = std::chrono::high_resolution_clock::now() - start_time;
+        if (!useSharedMemory) {
+            result = resultCopied.data();
+        }
+
+        if (status != protocol::Status::Ok) {
+            failures++;
+            if (status == protocol::Status::ConnectionError) {
+                failures += requests - i - 1;
+                return;
+            }
+            continue;
+        }
+        latencies.push_back(time.count());
+
+        // Checking the first response catches a broken server without slowing the load down.
+        if (i == 0) {
+            for (size_t j = 0; j < size; j++) {
+                if (std::fabs(result[j] - (SCALAR * x[j] + y[j] * x[j])) >= TOLERANCE) {
+                    std::cerr << "Result item #" << j << " is wrong" << std::endl;
+                    std::exit(1);
+                }
+            }
+        }
+    }
+}
+
+double percentile(const std::vector<double> &sorted, double fraction) {
+    return sorted[std::min(sorted.size() - 1, static_cast<size_t>(fraction * sorted.size()))];
+}
+
+/**
+ * Measures throughput and latency of a running opencl_daemon, sending vectors through the
+ * socket or through shared memory.
+ * Usage: opencl_loadgen [socket path] [clients] [requests per client] [vector size] [socket|shm]
+ **/
+int main(int argc, char *argv[]) {
+    const std::string socketPath = argc > 1 ? argv[1] : DEFAULT_SOCKET_PATH;
+    const int clients = argc > 2 ? std::atoi(argv[2]) : 4;
+    const int requests = argc > 3 ? std::atoi(argv[3]) : 1000;
+    const size_t size = argc > 4 ? std::strtoull(argv[4], nullptr, 10) : 4096;
+    const bool useSharedMemory = argc > 5 && std::string(argv[5]) == "shm";
+
+    std::vector<std::vector<double>> latencies(clients);
+    std::vector<int> failures(clients);
+    std::vector<std::thread> threads;
+
+    std::cout << "Sending " << clients << " x " << requests << " vadd requests of " << size << " elements to "
+              << socketPath << (useSharedMemory ? " through shared memory" : "") << std::endl;
+    auto start_time = std::chrono::high_resolution_clock::now();
+    for (int i = 0; i < clients; i++) {
+        threads.emplace_back(generateLoad, socketPath, requests, size, useSharedMemory, std::ref(latencies[i]),
+                             std::ref(failures[i]));
+    }
+    for (auto &thread: threads) {
+        thread.join();
+    }
+    std::chrono::duration<double> time = std::chrono::high_resolution_clock::now() - start_time;
+
+    std::vector<double> all;
+    for (const auto &clientLatencies: latencies) {
+        all.insert(all.end(), clientLatencies.begin(), clientLatencies.end());
+    }
+    std::sort(all.begin(), all.end());
+    int failed = 0;
+    for (int clientFailures: failures) {
+        failed += clientFailures;
+    }
+
+    if (all.empty()) {
+        std::cerr << "No request succeeded, " << failed << " failed" << std::endl;
+        return 1;
+    }
+
+    const double throughput = all.size() / time.count();
+    std::cout << std::fixed << std::setprecision(1)
+              << "Completed " << all.size() << " requests, " << failed << " failed, in " << time.count() * 1e3
+              << " ms\n"
+              << "Throughput: " << throughput << " requests/s, "
+              << throughput * 3 * sizeof(float) * size * 1e-6 << " MB/s\n"
+              << "Latency (us): p50 " << percentile(all, 0.50) * 1e6
+              << ", p90 " << percentile(all, 0.90) * 1e6
+              << ", p99 " << percentile(all, 0.99) * 1e6
+              << ", p99.9 " << percentile(all, 0.999) * 1e6
+              << ", max " << all.back() * 1e6 << std::endl;
+    return failed > 0 ? 1 : 0;
+}
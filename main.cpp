@@ -1,133 +1,216 @@
-#define CL_HPP_MINIMUM_OPENCL_VERSION 120
-#define CL_HPP_TARGET_OPENCL_VERSION 120
-
 #include <iostream>
 #include <CL/opencl.hpp>
-#include <fstream>
 #include <chrono>
 #include <cstdlib>
 #include <cmath>
 #include <limits>
 #include <iomanip>
-#include <numbers>
+#include <bit>
+#include <numeric>
+#include <span>
+#include <sstream>
+#include <thread>
+
+#include "bandwidth.h"
+#include "coexec.h"
+#include "dispatcher.h"
+#include "host.h"
+#include "image.h"
+#include "launch.h"
+#include "options.h"
+#include "arena.h"
+#include "pinned.h"
+#include "program.h"
+#include "resources.h"
+#include "scheduler.h"
+#include "sparse.h"
+#include "svm.h"
+#include "transfer.h"
+
+// Vectors of the harness, backed by the memory chosen in main, see --host-memory.
+using HostVector = std::vector<float, HostAllocator<float>>;
 
 void printSystemInfo(const cl::Device &device);
 
-void computeInParallel(std::vector<float> &, std::vector<float> &, cl::Context &, cl::Program &, cl::Device &);
+void computeInParallel(HostVector &, HostVector &, cl::Context &, cl::Program &, cl::Device &,
+                       KernelVariant, Verification);
+
+void computeInSequence(HostVector &, const HostVector &);
+
+void computeCoExecuted(HostVector &, HostVector &, cl::Context &, cl::Program &, cl::Device &);
+
+void computeScheduled(HostVector &, HostVector &, const std::vector<cl::Device> &);
+
+void computeDispatched(HostVector &, HostVector &, cl::Context &, cl::Program &, cl::Device &);
+
+void computeWithSvm(HostVector &, HostVector &, cl::Context &, cl::Program &, cl::Device &);
+
+void computeQuantized(HostVector &, HostVector &, cl::Context &, cl::Program &, cl::Device &, InputFormat);
+
+void computeSweep(HostVector &, HostVector &, cl::Context &, cl::Program &, cl::Device &);
+
+void checkResult(std::span<const float> result, std::span<const float>, std::span<const float>,
+                 std::span<const float> = {}, std::span<const float> = {});
 
-void computeInSequence(std::vector<float> &, const std::vector<float> &);
+void checkResultOnDevice(cl::CommandQueue &, cl::Program &, cl::Device &, cl::Buffer &, cl::Buffer &, cl::Buffer &);
 
-void checkResult(const std::vector<float> &result, const std::vector<float> &, const std::vector<float> &);
+void reportTiming(const std::string &, const std::vector<double> &);
+
+void printJson(std::ostream &, const cl::Device &, const ProgramResources &);
+
+// Run settings from the command line and environment, see options.h.
+Options options;
 
-const int VECTOR_SIZE = 1'572'864;
 const std::string KERNEL_PROGRAM_FILE = "kernel.cl";
-const float SCALAR = std::numbers::pi;
+// Latency models learned by the dispatcher, kept between runs.
+const std::string DISPATCHER_MODEL_FILE = "dispatcher_model.tsv";
+// Passes of the dispatcher over vector sizes from 1024 up to the vector size.
+const int DISPATCHER_ROUNDS = 4;
+
+// Timed runs of one computation, collected for the JSON output.
+struct Timing {
+    std::string name;
+    std::vector<double> seconds;
+};
+
+std::vector<Timing> timings;
 
 
 bool areSame(float a, float b) {
     std::cout << std::fixed << std::showpoint << std::setprecision(std::numeric_limits<float>::digits);
-    return std::fabs(a - b) < 1e-2;
+    return std::fabs(a - b) < options.tolerance;
 }
 
 float kernel(float a, float xi, float yi) {
     return a * xi + yi * xi;
 }
 
-int main() {
-    // prepare input data
-    srand(static_cast <unsigned> (time(0)));
-    const int MAX_VALUE = 100;
-    std::vector<float> a(VECTOR_SIZE), b(VECTOR_SIZE), result(VECTOR_SIZE);
-    for (int i = 0; i < VECTOR_SIZE; i++) {
-        a[i] = static_cast <float> (rand()) / (static_cast <float> (RAND_MAX / MAX_VALUE));
-        b[i] = static_cast <float> (rand()) / (static_cast <float> (RAND_MAX / MAX_VALUE));
-    }
-
-    // Search for all the OpenCL platforms available and check if there are any.
-    std::vector<cl::Platform> platforms;
-    cl::Platform::get(&platforms);
+// --local-size for launching vadd over the whole vector. vadd has no bounds check, so unless the size is a
+// multiple of the local size, which options only require when --kernel runs vadd, the runtime picks one.
+cl::NDRange vaddLocalRange() {
+    return options.localSize > 0 && options.size % options.localSize == 0 ? cl::NDRange(options.localSize)
+                                                                           : cl::NullRange;
+}
 
-    if (platforms.empty()) {
-        std::cerr << "No platforms found!" << std::endl;
-        exit(1);
-    } else {
-        std::cout << "Platforms found: " << platforms.size() << std::endl;
+int main(int argc, char *argv[]) {
+    options = parseOptions(argc, argv);
+    // In JSON mode stdout only gets the summary, everything else goes to stderr.
+    std::streambuf *stdoutBuffer = std::cout.rdbuf();
+    if (options.format == OutputFormat::Json) {
+        std::cout.rdbuf(std::cerr.rdbuf());
     }
 
-    auto platform = platforms.front();
-    std::vector<cl::Device> devices;
-    // Can be modified to devices CL_DEVICE_TYPE_GPU/CL_DEVICE_TYPE_CPU to select specified device
-    platform.getDevices(CL_DEVICE_TYPE_ALL, &devices);
-
-    if (devices.empty()) {
-        std::cerr << "No devices found!" << std::endl;
-        exit(1);
-    } else {
-        std::cout << "Devices found: " << devices.size() << std::endl;
-    }
+    // The devices of the selected platform, filtered by type and name or index.
+    std::vector<cl::Device> devices = selectDevices(options);
+    std::cout << "Devices found: " << devices.size() << std::endl;
 
     std::for_each(devices.begin(), devices.end(), printSystemInfo);
-
-
-    // Read OpenCL kernel file as a string.
-    std::ifstream kernel_file(KERNEL_PROGRAM_FILE);
-    std::string src(std::istreambuf_iterator<char>(kernel_file), (std::istreambuf_iterator<char>()));
-
-    if (src.empty()) {
-        std::cerr << "Kernel source file is empty!\n";
-        std::exit(1);
+    if (options.reports) {
+        printBandwidthReport(devices, options.size);
+        printTransferReport(devices, sizeof(float) * options.size);
+        printLaunchOverheadReport(devices);
+        printSparseReport(devices, options.size);
+        printImageReport(devices, options.size);
     }
 
-    // Compile kernel program which will run on the device.
-    cl::Program::Sources sources;
-    cl::Program program;    // The program that will run on the device.
-    cl::Context context;    // The context which holds the device.
-    cl::Device device = devices.front();      // The device where the kernel will run.
 
-    sources.emplace_back(src.c_str(), src.length());
-    context = cl::Context(device);
-    program = cl::Program(context, sources);
+    // Build the kernel program embedded into the executable at build time.
+    cl::Device device = devices.front();      // The device where the kernel will run.
+    cl::Context context(device);              // The context which holds the device.
+    // Only a non-default unroll needs compiling, the default can come precompiled.
+    const std::string buildOptions = options.unroll == Options().unroll
+                                     ? "" : "-DVADD_UNROLL=" + std::to_string(options.unroll);
+    cl::Program program = buildProgram(context, device, KERNEL_PROGRAM_FILE, buildOptions);
+    // The first thing to look at when a variant regresses: what the compiler made of it.
+    std::vector<std::string> kernelNames;
+    std::transform(options.variants.begin(), options.variants.end(), std::back_inserter(kernelNames), variantName);
+    const ProgramResources resources = programResources(program, device, kernelNames, options.localSize);
+    std::cout << "Kernel resources on " << device.getInfo<CL_DEVICE_NAME>() << ":\n";
+    printProgramResources(std::cout, resources);
+    // Declared before the vectors, so it outlives them.
+    PinnedMemory pinnedMemory(context, device);
+    // Devices sharing host memory wrap it without copies, so the host loops' TLB misses matter more than DMA.
+    HostMemory memory = options.hostMemory.value_or(device.getInfo<CL_DEVICE_HOST_UNIFIED_MEMORY>()
+                                                     ? HostMemory::HugePages : HostMemory::Pinned);
+    setHostMemory(memory, options.numaLocal);
+    std::cout << "Host vectors in " << hostMemoryName(memory) << " memory" << std::endl;
 
-    auto err = program.build();
-    if (err != CL_BUILD_SUCCESS) {
-        std::cerr << "Error!\nBuild Status: " << program.getBuildInfo<CL_PROGRAM_BUILD_STATUS>(device) << std::endl;
-        exit(1);
-    } else {
-        std::cout << "Kernel program " << KERNEL_PROGRAM_FILE << " build success\n";
+    // prepare input data
+    srand(static_cast <unsigned> (time(0)));
+    HostVector a(options.size), b(options.size);
+    for (size_t i = 0; i < options.size; i++) {
+        a[i] = static_cast <float> (rand()) / (static_cast <float> (RAND_MAX / options.maxValue));
+        b[i] = static_cast <float> (rand()) / (static_cast <float> (RAND_MAX / options.maxValue));
     }
 
     computeInSequence(a, b);
-    computeInParallel(a, b, context, program, device);
+    for (auto variant: options.variants) {
+        computeInParallel(a, b, context, program, device, variant,
+                          options.verification.value_or(variant == KernelVariant::GridStride ? Verification::Device
+                                                                                              : Verification::Host));
+    }
+    for (auto format: options.quantized) {
+        computeQuantized(a, b, context, program, device, format);
+    }
+    if (options.sweep > 0) {
+        computeSweep(a, b, context, program, device);
+    }
+    computeWithSvm(a, b, context, program, device);
+    computeCoExecuted(a, b, context, program, device);
+    computeScheduled(a, b, devices);
+    computeDispatched(a, b, context, program, device);
+    printHostMemoryStats(std::cout);
+
+    if (options.format == OutputFormat::Json) {
+        std::cout.rdbuf(stdoutBuffer);
+        printJson(std::cout, device, resources);
+    }
 }
 
-void computeInSequence(std::vector<float> &a, const std::vector<float> &b) {
-    std::vector<float> result(VECTOR_SIZE);
-    std::cout << "Compute addition of " << VECTOR_SIZE << " elements in sequence started\n";
-    auto start_time = std::chrono::high_resolution_clock::now();
+void computeInSequence(HostVector &a, const HostVector &b) {
+    HostVector result(options.size);
+    std::cout << "Compute addition of " << options.size << " elements in sequence started\n";
+    std::vector<double> seconds;
+    for (int run = 0; run < options.warmUp + options.iterations; run++) {
+        auto start_time = std::chrono::high_resolution_clock::now();
 
-    for (auto i = 0; i < VECTOR_SIZE; i++) {
-        result[i] = kernel(SCALAR, a[i], b[i]);
-    }
+        for (size_t i = 0; i < options.size; i++) {
+            result[i] = kernel(options.scalar, a[i], b[i]);
+        }
 
-    auto end_time = std::chrono::high_resolution_clock::now();
-    auto time = end_time - start_time;
+        std::chrono::duration<double> time = std::chrono::high_resolution_clock::now() - start_time;
+        if (run >= options.warmUp) {
+            seconds.push_back(time.count());
+        }
+    }
     checkResult(result, a, b);
-    std::cout << "Task finished in " << std::chrono::duration_cast<std::chrono::milliseconds>(time).count() << " ms\n";
+    reportTiming("sequence", seconds);
 }
 
-void computeInParallel(std::vector<float> &a, std::vector<float> &b, cl::Context &context, cl::Program &program,
-                       cl::Device &device) {
-    std::vector<float> result(VECTOR_SIZE);
+void computeInParallel(HostVector &a, HostVector &b, cl::Context &context, cl::Program &program,
+                       cl::Device &device, KernelVariant variant, Verification verification) {
+    HostVector result(options.size);
+    const size_t bytes = sizeof(float) * options.size;
     // Parallely performs the operations.
+    cl::CommandQueue queue(context, device);
+
+    // In place, the kernel overwrites one input, so it works on a copy of that one and writes its buffer.
+    const bool overX = options.result == ResultPlacement::OverX, overY = options.result == ResultPlacement::OverY;
+    HostVector overwritten = overX ? a : overY ? b : HostVector();
+    HostVector &x = overX ? overwritten : a;
+    HostVector &y = overY ? overwritten : b;
 
     // Create buffers and allocate memory on the device.
-    cl::Buffer aBuf(context, CL_MEM_USE_HOST_PTR, sizeof(float) * VECTOR_SIZE, a.data());
-    cl::Buffer bBuf(context, CL_MEM_USE_HOST_PTR, sizeof(float) * VECTOR_SIZE, b.data());
-    cl::Buffer cBuf(context, CL_MEM_WRITE_ONLY, sizeof(float) * VECTOR_SIZE);
+    cl::Buffer aBuf = createInputBuffer(context, queue, options.memoryMode, x.data(), bytes,
+                                        overX ? CL_MEM_READ_WRITE : CL_MEM_READ_ONLY);
+    cl::Buffer bBuf = createInputBuffer(context, queue, options.memoryMode, y.data(), bytes,
+                                        overY ? CL_MEM_READ_WRITE : CL_MEM_READ_ONLY);
+    cl::Buffer cBuf = overX ? aBuf : overY ? bBuf : cl::Buffer(context, CL_MEM_WRITE_ONLY, bytes);
 
     // create the kernel functor
     int32_t error = 0;
-    cl::Kernel kernel(program, "vadd", &error);
+    const std::string kernelName = variantName(variant);
+    cl::Kernel kernel(program, kernelName.c_str(), &error);
 
     if (error != 0) {
         if (error == CL_INVALID_KERNEL_NAME) {
@@ -135,45 +218,445 @@ void computeInParallel(std::vector<float> &a, std::vector<float> &b, cl::Context
             std::exit(1);
         }
     }
-    kernel.setArg(0, SCALAR);
+    kernel.setArg(0, options.scalar);
     kernel.setArg(1, aBuf);
     kernel.setArg(2, bBuf);
     kernel.setArg(3, cBuf);
 
-    cl::Event computeEvent;
+    cl::NDRange global(options.size);
+    if (variant == KernelVariant::GridStride) {
+        kernel.setArg(4, static_cast<cl_uint>(options.size));
+        global = cl::NDRange(gridStrideGlobalSize(kernel, device, options.size, options.localSize, options.unroll));
+    }
+    const cl::NDRange local = options.localSize > 0 ? cl::NDRange(options.localSize) : cl::NullRange;
 
     // Run the kernel function and collect its result.
+    std::cout << "Compute addition of " << options.size << " elements in parallel with " << kernelName
+              << ", " << memoryModeName(options.memoryMode) << " inputs, " << resultPlacementName(options.result)
+              << " result, started\n";
+    std::vector<double> seconds;
+    for (int run = 0; run < options.warmUp + options.iterations; run++) {
+        // Every run starts from the original inputs, restoring the overwritten one is not timed.
+        if (run > 0 && (overX || overY)) {
+            queue.enqueueWriteBuffer(cBuf, CL_TRUE, 0, bytes, overX ? a.data() : b.data());
+        }
+        cl::Event computeEvent;
+        auto start_time = std::chrono::high_resolution_clock::now();
+        queue.enqueueNDRangeKernel(kernel, cl::NullRange, global, local, nullptr, &computeEvent);
+        computeEvent.wait();
+        std::chrono::duration<double> time = std::chrono::high_resolution_clock::now() - start_time;
+        if (run >= options.warmUp) {
+            seconds.push_back(time.count());
+        }
+    }
+
+    // vadd_verify needs both inputs, in place the host checks against its own copies.
+    if (verification == Verification::Device && !overX && !overY) {
+        checkResultOnDevice(queue, program, device, aBuf, bBuf, cBuf);
+    } else {
+        queue.enqueueReadBuffer(cBuf, CL_TRUE, 0, bytes, result.data());
+        queue.finish();
+        checkResult(result, a, b);
+    }
+    std::string name = kernelName + " " + memoryModeName(options.memoryMode);
+    if (overX || overY) {
+        name += " ";
+        name += resultPlacementName(options.result);
+    }
+    reportTiming(name, seconds);
+}
+
+void computeQuantized(HostVector &a, HostVector &b, cl::Context &context, cl::Program &program,
+                      cl::Device &device, InputFormat format) {
+    const QuantizedVector qa = quantize(a, format), qb = quantize(b, format);
+    const size_t blockBytes = sizeof(QuantizationBlock) * qa.blocks.size();
     cl::CommandQueue queue(context, device);
 
-    std::cout << "Compute addition of " << VECTOR_SIZE << " elements in parallel started\n";
-    auto start_time = std::chrono::high_resolution_clock::now();
-    queue.enqueueNDRangeKernel(kernel, cl::NullRange, cl::NDRange(VECTOR_SIZE), cl::NDRange(12), nullptr,
-                               &computeEvent);
-    computeEvent.wait();
-    auto end_time = std::chrono::high_resolution_clock::now();
+    // Copied once, uploads below are timed separately from the kernel.
+    cl::Buffer aBuf(context, CL_MEM_READ_ONLY, qa.data.size());
+    cl::Buffer bBuf(context, CL_MEM_READ_ONLY, qb.data.size());
+    cl::Buffer aBlocksBuf(context, CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR, blockBytes,
+                          const_cast<QuantizationBlock *>(qa.blocks.data()));
+    cl::Buffer bBlocksBuf(context, CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR, blockBytes,
+                          const_cast<QuantizationBlock *>(qb.blocks.data()));
+    cl::Buffer cBuf(context, CL_MEM_WRITE_ONLY, sizeof(float) * options.size);
+
+    const std::string kernelName = quantizedKernelName(format);
+    cl::Kernel kernel(program, kernelName.c_str());
+    kernel.setArg(0, options.scalar);
+    kernel.setArg(1, aBuf);
+    kernel.setArg(2, aBlocksBuf);
+    kernel.setArg(3, bBuf);
+    kernel.setArg(4, bBlocksBuf);
+    kernel.setArg(5, cBuf);
+    kernel.setArg(6, static_cast<cl_uint>(options.size));
+    // The kernels skip work-items past the end, so the global size can round up to whole work-groups.
+    const size_t localSize = options.localSize;
+    const cl::NDRange global(localSize > 0 ? (options.size + localSize - 1) / localSize * localSize : options.size);
+    const cl::NDRange local = localSize > 0 ? cl::NDRange(localSize) : cl::NullRange;
+
+    std::cout << "Compute addition of " << options.size << " elements in parallel with " << kernelName
+              << ", inputs take " << (qa.data.size() + qb.data.size() + 2 * blockBytes) / 1024 << " KB instead of "
+              << 2 * sizeof(float) * options.size / 1024 << " KB, started\n";
+    std::vector<double> uploadSeconds, seconds;
+    for (int run = 0; run < options.warmUp + options.iterations; run++) {
+        auto start_time = std::chrono::high_resolution_clock::now();
+        queue.enqueueWriteBuffer(aBuf, CL_FALSE, 0, qa.data.size(), qa.data.data());
+        queue.enqueueWriteBuffer(bBuf, CL_TRUE, 0, qb.data.size(), qb.data.data());
+        std::chrono::duration<double> uploadTime = std::chrono::high_resolution_clock::now() - start_time;
+
+        cl::Event computeEvent;
+        start_time = std::chrono::high_resolution_clock::now();
+        queue.enqueueNDRangeKernel(kernel, cl::NullRange, global, local, nullptr, &computeEvent);
+        computeEvent.wait();
+        std::chrono::duration<double> time = std::chrono::high_resolution_clock::now() - start_time;
+        if (run >= options.warmUp) {
+            uploadSeconds.push_back(uploadTime.count());
+            seconds.push_back(time.count());
+        }
+    }
+
+    HostVector result(options.size), dequantizedA(options.size), dequantizedB(options.size);
+    queue.enqueueReadBuffer(cBuf, CL_TRUE, 0, sizeof(float) * options.size, result.data());
+    dequantize(qa, dequantizedA);
+    dequantize(qb, dequantizedB);
+    checkResult(result, dequantizedA, dequantizedB, a, b);
+    reportTiming("upload " + inputFormatName(format), uploadSeconds);
+    reportTiming(kernelName, seconds);
+}
+
+void computeSweep(HostVector &a, HostVector &b, cl::Context &context, cl::Program &program, cl::Device &device) {
+    const size_t count = options.sweep;
+    const size_t scalarBytes = sizeof(float) * count, bytes = sizeof(float) * options.size;
+    if (scalarBytes > device.getInfo<CL_DEVICE_MAX_CONSTANT_BUFFER_SIZE>() ||
+        count * bytes > device.getInfo<CL_DEVICE_MAX_MEM_ALLOC_SIZE>()) {
+        std::cout << "Skipping vadd_sweep, " << count << " scalars or their " << count * bytes / 1024
+                  << " KB of results exceed the device's constant or allocation size\n";
+        return;
+    }
+    // The --scalar value and the ones following it.
+    std::vector<float> scalars;
+    for (size_t k = 0; k < count; k++) {
+        scalars.push_back(options.scalar + static_cast<float>(k));
+    }
 
-    queue.enqueueReadBuffer(cBuf, CL_TRUE, 0, sizeof(float) * VECTOR_SIZE, result.data());
-    queue.finish();
+    cl::CommandQueue queue(context, device);
+    cl::Buffer scalarBuf(context, CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR, scalarBytes, scalars.data());
+    cl::Buffer aBuf(context, CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR, bytes, a.data());
+    cl::Buffer bBuf(context, CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR, bytes, b.data());
+    cl::Buffer sweepBuf(context, CL_MEM_WRITE_ONLY, count * bytes);
+    // The separate launches write the same amount, but one row at a time into the same buffer.
+    cl::Buffer cBuf(context, CL_MEM_WRITE_ONLY, bytes);
+
+    cl::Kernel sweep(program, "vadd_sweep");
+    sweep.setArg(0, scalarBuf);
+    sweep.setArg(1, static_cast<cl_uint>(count));
+    sweep.setArg(2, aBuf);
+    sweep.setArg(3, bBuf);
+    sweep.setArg(4, sweepBuf);
+    sweep.setArg(5, static_cast<cl_uint>(options.size));
+    cl::Kernel vadd(program, "vadd");
+    vadd.setArg(1, aBuf);
+    vadd.setArg(2, bBuf);
+    vadd.setArg(3, cBuf);
+    // vadd_sweep skips work-items past the end, so its global size can round up to whole work-groups.
+    const size_t localSize = options.localSize;
+    const cl::NDRange sweepGlobal(localSize > 0 ? (options.size + localSize - 1) / localSize * localSize
+                                                : options.size);
+    const cl::NDRange local = localSize > 0 ? cl::NDRange(localSize) : cl::NullRange;
+    const cl::NDRange vaddLocal = vaddLocalRange();
+
+    std::cout << "Compute addition of " << options.size << " elements for " << count
+              << " scalars with vadd_sweep, " << count << " vadd launches and on the host started\n";
+    HostVector hostResult(count * options.size);
+    std::vector<double> sweepSeconds, launchSeconds, hostSeconds;
+    for (int run = 0; run < options.warmUp + options.iterations; run++) {
+        cl::Event computeEvent;
+        auto start_time = std::chrono::high_resolution_clock::now();
+        cl_int error = queue.enqueueNDRangeKernel(sweep, cl::NullRange, sweepGlobal, local, nullptr, &computeEvent);
+        if (error != CL_SUCCESS) {
+            std::cerr << "vadd_sweep failed with OpenCL error " << error << std::endl;
+            std::exit(1);
+        }
+        computeEvent.wait();
+        std::chrono::duration<double> sweepTime = std::chrono::high_resolution_clock::now() - start_time;
+
+        start_time = std::chrono::high_resolution_clock::now();
+        for (float scalar: scalars) {
+            vadd.setArg(0, scalar);
+            error = queue.enqueueNDRangeKernel(vadd, cl::NullRange, cl::NDRange(options.size), vaddLocal);
+            if (error != CL_SUCCESS) {
+                std::cerr << "vadd for scalar " << scalar << " failed with OpenCL error " << error << std::endl;
+                std::exit(1);
+            }
+        }
+        queue.finish();
+        std::chrono::duration<double> launchTime = std::chrono::high_resolution_clock::now() - start_time;
+
+        start_time = std::chrono::high_resolution_clock::now();
+        vaddOnHostSweep(scalars.data(), count, a.data(), b.data(), hostResult.data(), options.size);
+        std::chrono::duration<double> hostTime = std::chrono::high_resolution_clock::now() - start_time;
+        if (run >= options.warmUp) {
+            sweepSeconds.push_back(sweepTime.count());
+            launchSeconds.push_back(launchTime.count());
+            hostSeconds.push_back(hostTime.count());
+        }
+    }
+
+    HostVector result(count * options.size), lastRow(options.size);
+    queue.enqueueReadBuffer(sweepBuf, CL_TRUE, 0, count * bytes, result.data());
+    // The separate launches all wrote cBuf, so it holds the row of the last scalar.
+    queue.enqueueReadBuffer(cBuf, CL_TRUE, 0, bytes, lastRow.data());
+    size_t errors = 0, lastRowErrors = 0;
+    for (size_t i = 0; i < result.size(); i++) {
+        errors += std::fabs(result[i] - hostResult[i]) >= options.tolerance;
+    }
+    const float *hostLastRow = hostResult.data() + (count - 1) * options.size;
+    for (size_t i = 0; i < options.size; i++) {
+        lastRowErrors += std::fabs(lastRow[i] - hostLastRow[i]) >= options.tolerance;
+    }
+    if (errors > 0) {
+        std::cout << errors << " of " << result.size() << " vadd_sweep results differ from the host's by "
+                  << options.tolerance << " or more\n";
+    } else {
+        std::cout << "All " << count << " rows of vadd_sweep match the host\n";
+    }
+    if (lastRowErrors > 0) {
+        std::cout << lastRowErrors << " of " << options.size << " results of the last vadd launch differ from the "
+                  << "host's by " << options.tolerance << " or more\n";
+    }
+    reportTiming("vadd_sweep", sweepSeconds);
+    reportTiming("vadd x" + std::to_string(count), launchSeconds);
+    reportTiming("host sweep", hostSeconds);
+    if (errors > 0 || lastRowErrors > 0) {
+        return;
+    }
+    const double best = *std::min_element(sweepSeconds.begin(), sweepSeconds.end());
+    std::cout << "vadd_sweep is " << std::setprecision(2)
+              << *std::min_element(launchSeconds.begin(), launchSeconds.end()) / best << " times as fast as "
+              << count << " vadd launches\n";
+}
+
+void computeWithSvm(HostVector &a, HostVector &b, cl::Context &context, cl::Program &program,
+                    cl::Device &device) {
+    auto modes = supportedSvmModes(device);
+    if (modes.empty()) {
+        std::cout << "No shared virtual memory in this build or on this device, vadd used buffers above\n";
+        return;
+    }
+
+    cl::CommandQueue queue(context, device);
+    cl::Kernel kernel(program, "vadd");
+    const cl::NDRange local = vaddLocalRange();
+    for (auto mode: modes) {
+        SvmArray x(context, options.size, mode), y(context, options.size, mode), c(context, options.size, mode);
+        if (x.data() == nullptr || y.data() == nullptr || c.data() == nullptr) {
+            std::cout << "Cannot allocate " << options.size << " elements of " << svmModeName(mode) << "\n";
+            continue;
+        }
+
+        auto skip = [&](const std::string &what, cl_int error) {
+            std::cout << "Cannot " << what << " " << svmModeName(mode) << ", OpenCL error " << error
+                      << ", skipping it\n";
+            queue.finish();
+        };
+
+        // The host writes the inputs where the kernel reads them, no buffers or copies in between.
+        cl_int error = x.map(queue, CL_MAP_WRITE_INVALIDATE_REGION);
+        if (error == CL_SUCCESS) {
+            error = y.map(queue, CL_MAP_WRITE_INVALIDATE_REGION);
+            if (error == CL_SUCCESS) {
+                std::copy(a.begin(), a.end(), x.data());
+                std::copy(b.begin(), b.end(), y.data());
+                error = y.unmap(queue);
+            }
+            const cl_int unmapped = x.unmap(queue);
+            error = error != CL_SUCCESS ? error : unmapped;
+        }
+        if (error != CL_SUCCESS) {
+            skip("write the inputs to", error);
+            continue;
+        }
+        kernel.setArg(0, options.scalar);
+        x.setAsArg(kernel, 1);
+        y.setAsArg(kernel, 2);
+        c.setAsArg(kernel, 3);
+
+        std::cout << "Compute addition of " << options.size << " elements in parallel with vadd on "
+                  << svmModeName(mode) << " started\n";
+        std::vector<double> seconds;
+        for (int run = 0; run < options.warmUp + options.iterations; run++) {
+            cl::Event computeEvent;
+            auto start_time = std::chrono::high_resolution_clock::now();
+            error = queue.enqueueNDRangeKernel(kernel, cl::NullRange, cl::NDRange(options.size), local, nullptr,
+                                               &computeEvent);
+            if (error != CL_SUCCESS) {
+                std::cerr << "vadd on " << svmModeName(mode) << " failed with OpenCL error " << error << std::endl;
+                std::exit(1);
+            }
+            computeEvent.wait();
+            std::chrono::duration<double> time = std::chrono::high_resolution_clock::now() - start_time;
+            if (run >= options.warmUp) {
+                seconds.push_back(time.count());
+            }
+        }
+
+        error = c.map(queue, CL_MAP_READ);
+        if (error != CL_SUCCESS) {
+            skip("read the result from", error);
+            continue;
+        }
+        checkResult({c.data(), c.size()}, a, b);
+        error = c.unmap(queue);
+        if (error != CL_SUCCESS) {
+            skip("hand the result back to", error);
+            continue;
+        }
+        queue.finish();
+        reportTiming("vadd " + svmModeName(mode), seconds);
+    }
+}
+
+void computeCoExecuted(HostVector &a, HostVector &b, cl::Context &context, cl::Program &program,
+                       cl::Device &device) {
+    HostVector result(options.size);
+    CoExecutor coExecutor(context, device, program, std::thread::hardware_concurrency());
+
+    // Each run re-balances the host/device split from the previous ones.
+    std::vector<double> seconds;
+    for (int run = 0; run < options.warmUp + options.iterations; run++) {
+        std::cout << "Compute addition of " << options.size << " elements on host and device started, "
+                  << std::fixed << std::setprecision(1) << 100 * coExecutor.hostFraction() << "% on host\n";
+        auto start_time = std::chrono::high_resolution_clock::now();
+        coExecutor.vadd(options.scalar, a, b, result);
+        std::chrono::duration<double> time = std::chrono::high_resolution_clock::now() - start_time;
+        checkResult(result, a, b);
+        if (run >= options.warmUp) {
+            seconds.push_back(time.count());
+        }
+    }
+    reportTiming("co-execution", seconds);
+}
+
+void computeScheduled(HostVector &a, HostVector &b, const std::vector<cl::Device> &devices) {
+    HostVector result(options.size);
+    ChunkScheduler scheduler(devices, std::thread::hardware_concurrency());
+
+    std::cout << "Compute addition of " << options.size << " elements on all devices and host threads started\n";
+    std::vector<double> seconds;
+    for (int run = 0; run < options.warmUp + options.iterations; run++) {
+        auto start_time = std::chrono::high_resolution_clock::now();
+        scheduler.vadd(options.scalar, a, b, result);
+        std::chrono::duration<double> time = std::chrono::high_resolution_clock::now() - start_time;
+        if (run >= options.warmUp) {
+            seconds.push_back(time.count());
+        }
+    }
 
-    auto time = end_time - start_time;
     checkResult(result, a, b);
-    std::cout << "Task finished in " << std::chrono::duration_cast<std::chrono::milliseconds>(time).count() << " ms\n";
+    for (const auto &worker: scheduler.lastStats()) {
+        std::cout << "  " << worker.name << ": " << worker.elements << " elements in " << worker.chunks
+                  << " chunks\n";
+    }
+    reportTiming("scheduled", seconds);
 }
 
-void checkResult(const std::vector<float> &result, const std::vector<float> &a, const std::vector<float> &b) {
-    if (result.size() != VECTOR_SIZE) {
-        std::cerr << "Vector size should equal " << VECTOR_SIZE << " but it's " << result.size() << std::endl;
+void computeDispatched(HostVector &a, HostVector &b, cl::Context &context, cl::Program &program,
+                       cl::Device &device) {
+    Dispatcher dispatcher(context, device, program, std::thread::hardware_concurrency(), DISPATCHER_MODEL_FILE);
+
+    std::vector<size_t> sizes;
+    for (size_t size = 1024; size < options.size; size *= 4) {
+        sizes.push_back(size);
+    }
+    sizes.push_back(options.size);
+
+    std::cout << "Compute addition routed by the dispatcher started\n" << std::fixed;
+    for (int round = 0; round < DISPATCHER_ROUNDS; round++) {
+        for (size_t size: sizes) {
+            HostVector x(a.begin(), a.begin() + size), y(b.begin(), b.begin() + size), result(size);
+            dispatcher.vadd(options.scalar, x, y, result);
+
+            const auto &decision = dispatcher.lastDecision();
+            std::cout << "  " << std::setw(8) << size << " elements: " << std::setw(12) << routeName(decision.route)
+                      << std::setprecision(1) << ", predicted " << decision.predictedSeconds * 1e6 << " us, took "
+                      << decision.measuredSeconds * 1e6 << " us\n";
+            if (size == options.size) {
+                checkResult(result, a, b);
+            }
+        }
+    }
+    dispatcher.printModels(std::cout);
+}
+
+// Checks result against a and b as the device saw them. Given the exact inputs a and b stand for, also reports
+// how far the result is from the one of exact inputs, the error of storing them in fewer bits.
+void checkResult(std::span<const float> result, std::span<const float> a, std::span<const float> b,
+                 std::span<const float> exactA, std::span<const float> exactB) {
+    if (result.size() != options.size) {
+        std::cerr << "Vector size should equal " << options.size << " but it's " << result.size() << std::endl;
         std::exit(1);
     }
 
-    for (int i = 0; i < VECTOR_SIZE; i++) {
-        const float singleResult = kernel(SCALAR, a[i], b[i]);
+    for (size_t i = 0; i < options.size; i++) {
+        const float singleResult = kernel(options.scalar, a[i], b[i]);
         if (!areSame(result[i], singleResult)) {
             std::cout << "Vector item #" << i << " should equal " << singleResult << " but is " << result[i]
                       << std::endl;
             std::exit(1);
         }
     }
+
+    if (exactA.empty() || exactB.empty()) {
+        return;
+    }
+    double maxError = 0, maxRelativeError = 0, squaredErrors = 0;
+    for (size_t i = 0; i < options.size; i++) {
+        const double exact = kernel(options.scalar, exactA[i], exactB[i]);
+        const double error = std::fabs(result[i] - exact);
+        maxError = std::max(maxError, error);
+        if (exact != 0) {
+            maxRelativeError = std::max(maxRelativeError, error / std::fabs(exact));
+        }
+        squaredErrors += error * error;
+    }
+    std::cout << "Accuracy against float inputs: largest error " << maxError << ", largest relative error "
+              << maxRelativeError << ", RMS error " << std::sqrt(squaredErrors / options.size) << "\n";
+}
+
+void checkResultOnDevice(cl::CommandQueue &queue, cl::Program &program, cl::Device &device, cl::Buffer &aBuf,
+                         cl::Buffer &bBuf, cl::Buffer &cBuf) {
+    // Mismatch count, first mismatching index and bits of the largest error, see vadd_verify.
+    cl_uint summary[3] = {0, std::numeric_limits<cl_uint>::max(), 0};
+    cl::Buffer summaryBuf(queue.getInfo<CL_QUEUE_CONTEXT>(), CL_MEM_READ_WRITE | CL_MEM_COPY_HOST_PTR, sizeof(summary),
+                          summary);
+
+    int32_t error = 0;
+    cl::Kernel kernel(program, "vadd_verify", &error);
+    if (error == CL_INVALID_KERNEL_NAME) {
+        std::cerr << "Invalid kernel name" << std::endl;
+        std::exit(1);
+    }
+    kernel.setArg(0, options.scalar);
+    kernel.setArg(1, aBuf);
+    kernel.setArg(2, bBuf);
+    kernel.setArg(3, cBuf);
+    kernel.setArg(4, static_cast<cl_uint>(options.size));
+    kernel.setArg(5, options.tolerance);
+    kernel.setArg(6, summaryBuf);
+
+    const size_t global = gridStrideGlobalSize(kernel, device, options.size, options.localSize, options.unroll);
+    queue.enqueueNDRangeKernel(kernel, cl::NullRange, cl::NDRange(global),
+                               options.localSize > 0 ? cl::NDRange(options.localSize) : cl::NullRange);
+    queue.enqueueReadBuffer(summaryBuf, CL_TRUE, 0, sizeof(summary), summary);
+
+    float maxError = std::bit_cast<float>(summary[2]);
+    if (summary[0] > 0) {
+        std::cout << summary[0] << " vector items differ by " << options.tolerance << " or more, first is #"
+                  << summary[1] << ", largest error is " << maxError << std::endl;
+        std::exit(1);
+    }
+    std::cout << "Verified on device, largest error is " << maxError << "\n";
 }
 
 void printSystemInfo(const cl::Device &device) {
@@ -198,3 +681,73 @@ void printSystemInfo(const cl::Device &device) {
               << std::endl;
 }
 
+
+void reportTiming(const std::string &name, const std::vector<double> &seconds) {
+    timings.push_back({name, seconds});
+    double best = *std::min_element(seconds.begin(), seconds.end());
+    if (seconds.size() == 1) {
+        std::cout << "Task finished in " << static_cast<long>(best * 1e3) << " ms\n";
+        return;
+    }
+    double mean = std::accumulate(seconds.begin(), seconds.end(), 0.0) / seconds.size();
+    std::cout << "Task finished in " << std::fixed << std::setprecision(3) << best * 1e3 << " ms at best, "
+              << mean * 1e3 << " ms on average over " << seconds.size() << " runs\n";
+}
+
+std::string jsonString(const std::string &text) {
+    std::ostringstream quoted;
+    quoted << '"';
+    for (unsigned char c: text) {
+        if (c == '"' || c == '\\') {
+            quoted << '\\' << c;
+        } else if (c < 0x20) {
+            quoted << "\\u" << std::hex << std::setw(4) << std::setfill('0') << static_cast<int>(c) << std::dec;
+        } else {
+            quoted << c;
+        }
+    }
+    quoted << '"';
+    return quoted.str();
+}
+
+void printJson(std::ostream &out, const cl::Device &device, const ProgramResources &resources) {
+    out << std::setprecision(9) << std::defaultfloat << std::noshowpoint << "{\n"
+        << "  \"device\": " << jsonString(device.getInfo<CL_DEVICE_NAME>()) << ",\n"
+        << "  \"driver\": " << jsonString(device.getInfo<CL_DRIVER_VERSION>()) << ",\n"
+        << "  \"size\": " << options.size << ",\n"
+        << "  \"iterations\": " << options.iterations << ",\n"
+        << "  \"warmUp\": " << options.warmUp << ",\n"
+        << "  \"localSize\": " << options.localSize << ",\n"
+        << "  \"unroll\": " << options.unroll << ",\n"
+        << "  \"memory\": " << jsonString(memoryModeName(options.memoryMode)) << ",\n"
+        << "  \"result\": " << jsonString(resultPlacementName(options.result)) << ",\n"
+        << "  \"hostMemory\": " << jsonString(hostMemoryName(hostMemory())) << ",\n"
+        << "  \"program\": {\"binaryBytes\": " << resources.binaryBytes
+        << ", \"buildOptions\": " << jsonString(resources.buildOptions)
+        << ", \"buildLog\": " << jsonString(resources.buildLog) << "},\n"
+        << "  \"kernels\": [";
+    for (size_t i = 0; i < resources.kernels.size(); i++) {
+        const auto &kernel = resources.kernels[i];
+        out << (i > 0 ? "," : "") << "\n    {\"name\": " << jsonString(kernel.name)
+            << ", \"workGroupSize\": " << kernel.workGroupSize
+            << ", \"preferredMultiple\": " << kernel.preferredMultiple
+            << ", \"privateBytes\": " << kernel.privateBytes
+            << ", \"localBytes\": " << kernel.localBytes
+            << ", \"localSize\": " << kernel.localSize
+            << ", \"occupancy\": " << kernel.occupancy << "}";
+    }
+    out << "\n  ],\n"
+        << "  \"runs\": [";
+    for (size_t i = 0; i < timings.size(); i++) {
+        const auto &seconds = timings[i].seconds;
+        out << (i > 0 ? "," : "") << "\n    {\"name\": " << jsonString(timings[i].name)
+            << ", \"bestSeconds\": " << *std::min_element(seconds.begin(), seconds.end())
+            << ", \"meanSeconds\": " << std::accumulate(seconds.begin(), seconds.end(), 0.0) / seconds.size()
+            << ", \"seconds\": [";
+        for (size_t run = 0; run < seconds.size(); run++) {
+            out << (run > 0 ? ", " : "") << seconds[run];
+        }
+        out << "]}";
+    }
+    out << "\n  ]\n}" << std::endl;
+}
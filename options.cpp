@@ -0,0 +1,348 @@
+#include "options.h"
+#include "ranking.h"
+
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <sstream>
+
+namespace {
+
+    const std::string ENVIRONMENT_PREFIX = "OPENCL_EXAMPLE_";
+    // Device probes of rankDevices, kept between runs.
+    const std::string RANKING_FILE = "device_ranking.tsv";
+
+    struct OptionSpec {
+        std::string name;
+        std::string value;  // Placeholder shown in the usage
+        std::string help;
+        std::function<bool(Options &, const std::string &)> set;
+    };
+
+    template<typename T>
+    bool parseInteger(const std::string &text, T &value, T min) {
+        T parsed;
+        auto [end, error] = std::from_chars(text.data(), text.data() + text.size(), parsed);
+        if (error != std::errc() || end != text.data() + text.size() || parsed < min) {
+            return false;
+        }
+        value = parsed;
+        return true;
+    }
+
+    bool parseFloat(const std::string &text, float &value) {
+        char *end = nullptr;
+        float parsed = std::strtof(text.c_str(), &end);
+        if (text.empty() || *end != '\0') {
+            return false;
+        }
+        value = parsed;
+        return true;
+    }
+
+    // Picks `value` from `names`, which maps each accepted spelling to its value.
+    template<typename T>
+    bool parseChoice(const std::string &text, T &value, const std::vector<std::pair<std::string, T>> &names) {
+        for (const auto &[name, choice]: names) {
+            if (name == text) {
+                value = choice;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    const std::vector<OptionSpec> &optionSpecs() {
+        static const std::vector<OptionSpec> specs = {
+                {"size", "N", "elements per vector", [](Options &o, const std::string &v) {
+                    return parseInteger<size_t>(v, o.size, 1);
+                }},
+                {"iterations", "N", "timed runs of every computation", [](Options &o, const std::string &v) {
+                    return parseInteger(v, o.iterations, 1);
+                }},
+                {"warm-up", "N", "untimed runs before the timed ones", [](Options &o, const std::string &v) {
+                    return parseInteger(v, o.warmUp, 0);
+                }},
+                {"scalar", "X", "scalar a of a * x + y * x", [](Options &o, const std::string &v) {
+                    return parseFloat(v, o.scalar);
+                }},
+                {"max-value", "X", "inputs are random in [0, X]", [](Options &o, const std::string &v) {
+                    return parseFloat(v, o.maxValue) && o.maxValue > 0;
+                }},
+                {"platform", "INDEX|NAME", "platform by index or name substring", [](Options &o, const std::string &v) {
+                    o.platform = v;
+                    return true;
+                }},
+                {"device", "INDEX|NAME", "device by index or name substring", [](Options &o, const std::string &v) {
+                    o.device = v;
+                    return true;
+                }},
+                {"device-type", "all|cpu|gpu|accelerator|default", "devices to consider",
+                 [](Options &o, const std::string &v) {
+                     return parseChoice<cl_device_type>(v, o.deviceType, {{"all", CL_DEVICE_TYPE_ALL},
+                                                                          {"cpu", CL_DEVICE_TYPE_CPU},
+                                                                          {"gpu", CL_DEVICE_TYPE_GPU},
+                                                                          {"accelerator", CL_DEVICE_TYPE_ACCELERATOR},
+                                                                          {"default", CL_DEVICE_TYPE_DEFAULT}});
+                 }},
+                {"rank", "on|off", "order devices of all platforms by a cached probe, else the platform's order",
+                 [](Options &o, const std::string &v) {
+                     return parseChoice<bool>(v, o.rank, {{"on", true}, {"off", false}});
+                 }},
+                {"top", "N", "ranked devices to use, 0 for all", [](Options &o, const std::string &v) {
+                    return parseInteger<size_t>(v, o.top, 0);
+                }},
+                {"kernel", "all|simple|stride", "vadd variants to run", [](Options &o, const std::string &v) {
+                    using Variants = std::vector<KernelVariant>;
+                    return parseChoice<Variants>(v, o.variants, {{"all", {KernelVariant::Simple,
+                                                                          KernelVariant::GridStride}},
+                                                                 {"simple", {KernelVariant::Simple}},
+                                                                 {"stride", {KernelVariant::GridStride}}});
+                }},
+                {"local-size", "N", "work-group size, 0 for the runtime's choice",
+                 [](Options &o, const std::string &v) {
+                     return parseInteger<size_t>(v, o.localSize, 0);
+                 }},
+                {"unroll", "N", "elements per pass of a vadd_stride work-item", [](Options &o, const std::string &v) {
+                    return parseInteger(v, o.unroll, 1);
+                }},
+                {"memory", "use-host-ptr|copy-host-ptr|alloc-host-ptr|device", "placement of the inputs",
+                 [](Options &o, const std::string &v) {
+                     return parseChoice<MemoryMode>(v, o.memoryMode, {{"use-host-ptr", MemoryMode::UseHostPtr},
+                                                                      {"copy-host-ptr", MemoryMode::CopyHostPtr},
+                                                                      {"alloc-host-ptr", MemoryMode::AllocHostPtr},
+                                                                      {"device", MemoryMode::Device}});
+                 }},
+                {"result", "separate|over-x|over-y", "buffer vadd writes to, in place needs a third less memory",
+                 [](Options &o, const std::string &v) {
+                     return parseChoice<ResultPlacement>(v, o.result, {{"separate", ResultPlacement::Separate},
+                                                                       {"over-x", ResultPlacement::OverX},
+                                                                       {"over-y", ResultPlacement::OverY}});
+                 }},
+                {"quantized", "all|none|int8|uint8|int16", "quantised input formats to run vadd on",
+                 [](Options &o, const std::string &v) {
+                     using Formats = std::vector<InputFormat>;
+                     return parseChoice<Formats>(v, o.quantized, {{"all", {InputFormat::Int8, InputFormat::UInt8,
+                                                                           InputFormat::Int16}},
+                                                                  {"none", {}},
+                                                                  {"int8", {InputFormat::Int8}},
+                                                                  {"uint8", {InputFormat::UInt8}},
+                                                                  {"int16", {InputFormat::Int16}}});
+                 }},
+                {"sweep", "N", "scalars vadd_sweep computes in one pass over x and y, 0 to skip it",
+                 [](Options &o, const std::string &v) {
+                     return parseInteger<size_t>(v, o.sweep, 0);
+                 }},
+                {"tolerance", "X", "largest difference from the host's result that passes verification",
+                 [](Options &o, const std::string &v) {
+                     return parseFloat(v, o.tolerance) && o.tolerance > 0;
+                 }},
+                {"verify", "auto|host|device", "where results are checked, auto picks the device for stride only",
+                 [](Options &o, const std::string &v) {
+                     return parseChoice<std::optional<Verification>>(v, o.verification,
+                                                                     {{"auto", std::nullopt},
+                                                                      {"host", Verification::Host},
+                                                                      {"device", Verification::Device}});
+                 }},
+                {"host-memory", "auto|default|pinned|huge-pages", "backing of the host vectors",
+                 [](Options &o, const std::string &v) {
+                     return parseChoice<std::optional<HostMemory>>(v, o.hostMemory,
+                                                                   {{"auto", std::nullopt},
+                                                                    {"default", HostMemory::Default},
+                                                                    {"pinned", HostMemory::Pinned},
+                                                                    {"huge-pages", HostMemory::HugePages}});
+                 }},
+                {"numa", "on|off", "place huge pages on the NUMA node of the main thread",
+                 [](Options &o, const std::string &v) {
+                     return parseChoice<bool>(v, o.numaLocal, {{"on", true}, {"off", false}});
+                 }},
+                {"format", "text|json", "output format", [](Options &o, const std::string &v) {
+                    return parseChoice<OutputFormat>(v, o.format, {{"text", OutputFormat::Text},
+                                                                   {"json", OutputFormat::Json}});
+                }},
+                {"reports", "on|off", "bandwidth, transfer, launch overhead, sparse and image reports",
+                 [](Options &o, const std::string &v) {
+                     return parseChoice<bool>(v, o.reports, {{"on", true}, {"off", false}});
+                 }},
+        };
+        return specs;
+    }
+
+    std::string environmentName(const std::string &name) {
+        std::string variable = ENVIRONMENT_PREFIX + name;
+        std::transform(variable.begin(), variable.end(), variable.begin(), [](unsigned char c) {
+            return c == '-' ? '_' : std::toupper(c);
+        });
+        return variable;
+    }
+
+    void set(Options &options, const OptionSpec &spec, const std::string &value, const std::string &source) {
+        if (!spec.set(options, value)) {
+            std::cerr << "Invalid value '" << value << "' for " << source << ", expected " << spec.value << "\n";
+            printUsage(std::cerr);
+            std::exit(1);
+        }
+    }
+
+    std::string lowerCase(std::string text) {
+        std::transform(text.begin(), text.end(), text.begin(), [](unsigned char c) { return std::tolower(c); });
+        return text;
+    }
+
+    // Index of the entry selected by `filter`, a number or a case-insensitive name substring, or -1.
+    int find(const std::vector<std::string> &names, const std::string &filter) {
+        size_t index;
+        if (parseInteger<size_t>(filter, index, 0)) {
+            return index < names.size() ? static_cast<int>(index) : -1;
+        }
+        for (size_t i = 0; i < names.size(); i++) {
+            if (lowerCase(names[i]).find(lowerCase(filter)) != std::string::npos) {
+                return static_cast<int>(i);
+            }
+        }
+        return -1;
+    }
+}
+
+Options parseOptions(int argc, char *argv[]) {
+    Options options;
+    for (const auto &spec: optionSpecs()) {
+        const std::string variable = environmentName(spec.name);
+        if (const char *value = std::getenv(variable.c_str())) {
+            set(options, spec, value, variable);
+        }
+    }
+
+    for (int i = 1; i < argc; i++) {
+        std::string argument = argv[i];
+        if (argument == "--help" || argument == "-h") {
+            printUsage(std::cout);
+            std::exit(0);
+        }
+        std::string value;
+        const bool hasValue = argument.find('=') != std::string::npos;
+        if (hasValue) {
+            value = argument.substr(argument.find('=') + 1);
+            argument.resize(argument.find('='));
+        }
+        auto spec = std::find_if(optionSpecs().begin(), optionSpecs().end(), [&](const OptionSpec &candidate) {
+            return "--" + candidate.name == argument;
+        });
+        if (spec == optionSpecs().end() || (!hasValue && i + 1 >= argc)) {
+            std::cerr << "Unknown option or missing value: " << argv[i] << "\n";
+            printUsage(std::cerr);
+            std::exit(1);
+        }
+        set(options, *spec, hasValue ? value : argv[++i], argument);
+    }
+
+    // vadd has no bounds check, so each of its work-groups has to be full.
+    const bool runsSimple = std::find(options.variants.begin(), options.variants.end(), KernelVariant::Simple) !=
+                            options.variants.end();
+    if (runsSimple && options.localSize > 0 && options.size % options.localSize != 0) {
+        std::cerr << "--size " << options.size << " is not a multiple of --local-size " << options.localSize
+                  << ", which vadd requires. Use --local-size 0 or --kernel stride." << std::endl;
+        std::exit(1);
+    }
+    return options;
+}
+
+void printUsage(std::ostream &out) {
+    Options defaults;
+    out << "Usage: opencl_example [--option value]...\n"
+        << "Every option can also be set through the environment variable shown.\n";
+    for (const auto &spec: optionSpecs()) {
+        std::ostringstream option;
+        option << "--" << spec.name << " " << spec.value;
+        out << "  " << option.str() << "\n      " << spec.help << ", " << environmentName(spec.name) << "\n";
+    }
+    out << std::flush;
+}
+
+std::vector<cl::Device> selectDevices(const Options &options) {
+    if (options.rank && options.platform.empty() && options.device.empty()) {
+        auto ranking = rankDevices(options.size, options.deviceType, RANKING_FILE);
+        printRanking(ranking, std::cout);
+        std::vector<cl::Device> devices;
+        for (const auto &rank: ranking) {
+            if (rank.capability > 0 && (options.top == 0 || devices.size() < options.top)) {
+                devices.push_back(rank.device);
+            }
+        }
+        if (devices.empty()) {
+            std::cerr << "No devices found!" << std::endl;
+            std::exit(1);
+        }
+        return devices;
+    }
+
+    std::vector<cl::Platform> platforms;
+    cl::Platform::get(&platforms);
+    if (platforms.empty()) {
+        std::cerr << "No platforms found!" << std::endl;
+        std::exit(1);
+    }
+
+    cl::Platform platform = platforms.front();
+    if (!options.platform.empty()) {
+        std::vector<std::string> names;
+        for (const auto &candidate: platforms) {
+            names.push_back(candidate.getInfo<CL_PLATFORM_NAME>());
+        }
+        int index = find(names, options.platform);
+        if (index < 0) {
+            std::cerr << "No platform matches '" << options.platform << "'" << std::endl;
+            std::exit(1);
+        }
+        platform = platforms[index];
+    }
+
+    std::vector<cl::Device> devices;
+    platform.getDevices(options.deviceType, &devices);
+    if (!options.device.empty()) {
+        std::vector<std::string> names;
+        for (const auto &candidate: devices) {
+            names.push_back(candidate.getInfo<CL_DEVICE_NAME>());
+        }
+        int index = find(names, options.device);
+        devices = index < 0 ? std::vector<cl::Device>() : std::vector<cl::Device>{devices[index]};
+    }
+    if (devices.empty()) {
+        std::cerr << "No devices found!" << std::endl;
+        std::exit(1);
+    }
+    return devices;
+}
+
+std::string variantName(KernelVariant variant) {
+    return variant == KernelVariant::GridStride ? "vadd_stride" : "vadd";
+}
+
+std::string memoryModeName(MemoryMode mode) {
+    switch (mode) {
+        case MemoryMode::UseHostPtr:
+            return "use-host-ptr";
+        case MemoryMode::CopyHostPtr:
+            return "copy-host-ptr";
+        case MemoryMode::AllocHostPtr:
+            return "alloc-host-ptr";
+        case MemoryMode::Device:
+            return "device";
+    }
+    return "";
+}
+
+std::string resultPlacementName(ResultPlacement placement) {
+    switch (placement) {
+        case ResultPlacement::Separate:
+            return "separate";
+        case ResultPlacement::OverX:
+            return "over-x";
+        case ResultPlacement::OverY:
+            return "over-y";
+    }
+    return "";
+}
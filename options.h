@@ -0,0 +1,93 @@
+#pragma once
+
+#include "arena.h"
+#include "quantize.h"
+
+#include <CL/opencl.hpp>
+#include <numbers>
+#include <optional>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// Kernel functions from kernel.cl which computeInParallel can launch.
+enum class KernelVariant {
+    Simple,     // vadd: one work-item per element
+    GridStride  // vadd_stride: VADD_UNROLL elements per work-item, global size fitted to the device
+};
+
+// How computeInParallel places its inputs.
+enum class MemoryMode {
+    UseHostPtr,     // wrap the host vectors with CL_MEM_USE_HOST_PTR
+    CopyHostPtr,    // copy them into the buffer when it is created
+    AllocHostPtr,   // allocate host accessible buffers with CL_MEM_ALLOC_HOST_PTR and write them
+    Device          // allocate device buffers and write them
+};
+
+// Where computeInParallel writes the result. In place, two buffers hold the vectors instead of three.
+enum class ResultPlacement {
+    Separate,   // a third, write-only buffer
+    OverX,      // over the input x, whose buffer becomes read-write
+    OverY       // over the input y, whose buffer becomes read-write
+};
+
+// Where computeInParallel checks the result.
+enum class Verification {
+    Host,   // read the result back and compare it in checkResult
+    Device  // compare on the device with vadd_verify and read back only the summary
+};
+
+enum class OutputFormat {
+    Text,
+    Json    // progress goes to stderr and a summary of all timings to stdout
+};
+
+/**
+ * Settings of an opencl_example run. Each can be given as --name value or --name=value,
+ * or through the environment as OPENCL_EXAMPLE_NAME, which the command line overrides.
+ **/
+struct Options {
+    size_t size = 1'572'864;
+    int iterations = 1;
+    int warmUp = 0;
+    float scalar = std::numbers::pi;
+    float maxValue = 100;                   // Inputs are random in [0, maxValue]
+    std::string platform;                   // Index or name substring, the first platform if empty
+    std::string device;                     // Index or name substring, all devices of the type if empty
+    cl_device_type deviceType = CL_DEVICE_TYPE_ALL;
+    bool rank = true;                       // Without platform and device, order all devices by rankDevices
+    size_t top = 0;                         // Ranked devices to use, 0 for all
+    std::vector<KernelVariant> variants = {KernelVariant::Simple, KernelVariant::GridStride};
+    size_t localSize = 12;                  // 0 leaves the work-group size to the runtime
+    int unroll = 4;                         // Passed to kernel.cl as VADD_UNROLL
+    MemoryMode memoryMode = MemoryMode::UseHostPtr;
+    ResultPlacement result = ResultPlacement::Separate;
+    std::vector<InputFormat> quantized = {InputFormat::Int8, InputFormat::UInt8, InputFormat::Int16};
+    size_t sweep = 16;                      // Scalars of the vadd_sweep run, 0 to skip it
+    float tolerance = 1e-2;                 // Largest difference from the host's result that passes
+    // Where results of computeInParallel are checked, if empty on the device for vadd_stride and the host for vadd.
+    std::optional<Verification> verification;
+    // Backing of the harness vectors, if empty huge pages for devices sharing host memory and pinned otherwise.
+    std::optional<HostMemory> hostMemory;
+    bool numaLocal = true;                  // Huge page arena prefers the NUMA node of the main thread
+    OutputFormat format = OutputFormat::Text;
+    bool reports = true;                    // Bandwidth, transfer, launch overhead, sparse and image reports
+};
+
+// Reads the environment, then the command line. Prints the usage and exits on --help or invalid values.
+Options parseOptions(int argc, char *argv[]);
+
+void printUsage(std::ostream &out);
+
+/**
+ * The devices of the selected platform matching the device type and filter. Without either
+ * and with ranking on, the best `top` devices of all platforms instead, best first, see
+ * rankDevices. Exits the application when no platform or device matches.
+ **/
+std::vector<cl::Device> selectDevices(const Options &options);
+
+std::string variantName(KernelVariant variant);
+
+std::string memoryModeName(MemoryMode mode);
+
+std::string resultPlacementName(ResultPlacement placement);
@@ -0,0 +1,144 @@
+#include "pinned.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+
+namespace {
+
+    // Page alignment lets drivers wrap and DMA blocks without an offset.
+    const size_t ALIGNMENT = 4096;
+    // Regions are at least this large so many vectors share one mapping.
+    const size_t REGION_BYTES = 64 << 20;
+
+    PinnedMemory *active = nullptr;
+    std::mutex activeMutex;
+
+    // Regions of a PinnedMemory destroyed while blocks were in use, never unmapped so those stay valid.
+    std::vector<std::pair<char *, size_t>> abandoned;
+
+    size_t alignUp(size_t bytes) {
+        return (std::max<size_t>(bytes, 1) + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+    }
+}
+
+PinnedMemory::PinnedMemory(const cl::Context &context, const cl::Device &device)
+        : context(context), queue(context, device),
+          maxRegionBytes(device.getInfo<CL_DEVICE_MAX_MEM_ALLOC_SIZE>()) {
+    std::lock_guard lock(activeMutex);
+    if (active != nullptr) {
+        std::cerr << "Only one PinnedMemory can exist at a time" << std::endl;
+        std::exit(1);
+    }
+    active = this;
+}
+
+PinnedMemory::~PinnedMemory() {
+    std::lock_guard lock(activeMutex);
+    active = nullptr;
+    if (used > 0) {
+        std::cerr << "PinnedMemory destroyed with " << used << " bytes in use, keeping its regions" << std::endl;
+        for (const auto &region: regions) {
+            abandoned.emplace_back(region.data, region.bytes);
+        }
+        return;
+    }
+    for (const auto &region: regions) {
+        queue.enqueueUnmapMemObject(region.buffer, region.data);
+    }
+    queue.finish();
+}
+
+void *PinnedMemory::allocate(size_t bytes) {
+    {
+        std::lock_guard lock(activeMutex);
+        if (active != nullptr) {
+            if (void *pointer = active->take(alignUp(bytes))) {
+                return pointer;
+            }
+        }
+    }
+    void *pointer = std::aligned_alloc(ALIGNMENT, alignUp(bytes));
+    if (pointer == nullptr) {
+        throw std::bad_alloc();
+    }
+    return pointer;
+}
+
+void PinnedMemory::deallocate(void *pointer, size_t bytes) {
+    std::lock_guard lock(activeMutex);
+    if (active != nullptr && active->give(pointer, alignUp(bytes))) {
+        return;
+    }
+    auto *data = static_cast<char *>(pointer);
+    for (const auto &[begin, size]: abandoned) {
+        if (data >= begin && data < begin + size) {
+            return;
+        }
+    }
+    std::free(pointer);
+}
+
+size_t PinnedMemory::pooledBytes() const {
+    std::lock_guard lock(mutex);
+    size_t bytes = 0;
+    for (const auto &region: regions) {
+        bytes += region.bytes;
+    }
+    return bytes;
+}
+
+size_t PinnedMemory::usedBytes() const {
+    std::lock_guard lock(mutex);
+    return used;
+}
+
+void *PinnedMemory::take(size_t bytes) {
+    std::lock_guard lock(mutex);
+    size_t offset;
+    for (auto &region: regions) {
+        if (region.free.take(bytes, ALIGNMENT, offset)) {
+            used += bytes;
+            return region.data + offset;
+        }
+    }
+
+    const size_t regionBytes = std::max(bytes, REGION_BYTES);
+    if (regionBytes > maxRegionBytes) {
+        return nullptr;
+    }
+    cl_int error = CL_SUCCESS;
+    cl::Buffer buffer(context, CL_MEM_READ_WRITE | CL_MEM_ALLOC_HOST_PTR, regionBytes, nullptr, &error);
+    void *mapped = nullptr;
+    if (error == CL_SUCCESS) {
+        mapped = queue.enqueueMapBuffer(buffer, CL_TRUE, CL_MAP_READ | CL_MAP_WRITE, 0, regionBytes, nullptr,
+                                        nullptr, &error);
+    }
+    // Mappings are only page aligned in practice, the blocks rely on it.
+    if (error != CL_SUCCESS || reinterpret_cast<uintptr_t>(mapped) % ALIGNMENT != 0) {
+        if (error == CL_SUCCESS) {
+            queue.enqueueUnmapMemObject(buffer, mapped);
+        }
+        return nullptr;
+    }
+
+    regions.push_back({buffer, static_cast<char *>(mapped), regionBytes, FreeBlocks(regionBytes)});
+    regions.back().free.take(bytes, ALIGNMENT, offset);
+    used += bytes;
+    return mapped;
+}
+
+bool PinnedMemory::give(void *pointer, size_t bytes) {
+    std::lock_guard lock(mutex);
+    auto *data = static_cast<char *>(pointer);
+    for (auto &region: regions) {
+        if (data >= region.data && data < region.data + region.bytes) {
+            region.free.give(data - region.data, bytes);
+            used -= bytes;
+            return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include "blocks.h"
+
+#include <CL/opencl.hpp>
+#include <cstddef>
+#include <mutex>
+#include <vector>
+
+/**
+ * While alive, makes PinnedAllocator sub-allocate from large CL_MEM_ALLOC_HOST_PTR buffers
+ * of the context, each mapped once and kept as a pool for later allocations. Drivers move
+ * such page-locked memory by DMA instead of staging it through their own pinned buffers.
+ * Only one may exist at a time, and containers using its memory should be gone before it.
+ **/
+class PinnedMemory {
+public:
+    PinnedMemory(const cl::Context &context, const cl::Device &device);
+
+    ~PinnedMemory();
+
+    PinnedMemory(const PinnedMemory &) = delete;
+
+    PinnedMemory &operator=(const PinnedMemory &) = delete;
+
+    // Page aligned memory from the pool, or from aligned malloc when there is no PinnedMemory or no region fits.
+    static void *allocate(size_t bytes);
+
+    static void deallocate(void *pointer, size_t bytes);
+
+    // Bytes mapped from the driver, and the part of them handed out.
+    size_t pooledBytes() const;
+
+    size_t usedBytes() const;
+
+private:
+    struct Region {
+        cl::Buffer buffer;
+        char *data;
+        size_t bytes;
+        FreeBlocks free;
+    };
+
+    void *take(size_t bytes);
+
+    bool give(void *pointer, size_t bytes);
+
+    cl::Context context;
+    cl::CommandQueue queue;
+    size_t maxRegionBytes;
+    std::vector<Region> regions;
+    size_t used = 0;
+    mutable std::mutex mutex;
+};
+
+// Allocator for std::vector<T, PinnedAllocator<T>>, see PinnedMemory.
+template<typename T>
+struct PinnedAllocator {
+    using value_type = T;
+
+    PinnedAllocator() = default;
+
+    template<typename U>
+    PinnedAllocator(const PinnedAllocator<U> &) {}
+
+    T *allocate(size_t n) {
+        return static_cast<T *>(PinnedMemory::allocate(sizeof(T) * n));
+    }
+
+    void deallocate(T *pointer, size_t n) {
+        PinnedMemory::deallocate(pointer, sizeof(T) * n);
+    }
+
+    template<typename U>
+    bool operator==(const PinnedAllocator<U> &) const {
+        return true;
+    }
+};
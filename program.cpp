@@ -0,0 +1,105 @@
+#include "program.h"
+#include "embedded_kernels.h"
+
+#include <cstdlib>
+#include <iostream>
+#include <span>
+
+namespace {
+
+    const embedded::KernelFile *findKernelFile(const std::string &fileName) {
+        for (const auto &file: embedded::KERNEL_FILES) {
+            if (file.name == fileName) {
+                return &file;
+            }
+        }
+        return nullptr;
+    }
+
+    bool hasExtension(const cl::Device &device, const std::string &extension) {
+        return device.getInfo<CL_DEVICE_EXTENSIONS>().find(extension) != std::string::npos;
+    }
+
+    // poclcc binaries only load on the kind of device they were compiled for, anything else fails here.
+    cl::Program programFromBinary(const cl::Context &context, const cl::Device &device,
+                                  std::span<const unsigned char> binary) {
+        if (binary.empty()) {
+            return {};
+        }
+
+        cl::Program::Binaries binaries{{binary.begin(), binary.end()}};
+        std::vector<cl_int> status;
+        cl_int error = CL_SUCCESS;
+        cl::Program program(context, std::vector<cl::Device>{device}, binaries, &status, &error);
+        return error == CL_SUCCESS ? program : cl::Program();
+    }
+
+    // clCreateProgramWithIL is OpenCL 2.1, so go through cl_khr_il_program to stay on 1.2 headers.
+    cl::Program programFromSpirv(const cl::Context &context, const cl::Device &device,
+                                 std::span<const unsigned char> spirv) {
+        if (spirv.empty() || !hasExtension(device, "cl_khr_il_program")) {
+            return {};
+        }
+
+        using CreateProgramWithIL = cl_program (CL_API_CALL *)(cl_context, const void *, size_t, cl_int *);
+        cl::Platform platform(device.getInfo<CL_DEVICE_PLATFORM>());
+        auto create = reinterpret_cast<CreateProgramWithIL>(
+                clGetExtensionFunctionAddressForPlatform(platform(), "clCreateProgramWithILKHR"));
+        if (create == nullptr) {
+            return {};
+        }
+
+        cl_int error = CL_SUCCESS;
+        cl_program program = create(context(), spirv.data(), spirv.size(), &error);
+        return error == CL_SUCCESS ? cl::Program(program) : cl::Program();
+    }
+
+    bool tryBuild(const cl::Program &program, const cl::Device &device) {
+        return program() != nullptr && program.build(std::vector<cl::Device>{device}) == CL_SUCCESS;
+    }
+}
+
+cl_int tryBuildProgram(const cl::Context &context, const cl::Device &device, const std::string &fileName,
+                       cl::Program &program, const std::string &options) {
+    auto file = findKernelFile(fileName);
+    if (file == nullptr) {
+        return CL_INVALID_VALUE;
+    }
+
+    // Precompiled kernels were built without extra options, so they only match a default build.
+    if (options.empty()) {
+        if (program = programFromBinary(context, device, file->binary); tryBuild(program, device)) {
+            std::cout << "Kernel program " << fileName << " loaded from precompiled binary\n";
+            return CL_SUCCESS;
+        }
+        if (program = programFromSpirv(context, device, file->spirv); tryBuild(program, device)) {
+            std::cout << "Kernel program " << fileName << " loaded from precompiled SPIR-V\n";
+            return CL_SUCCESS;
+        }
+    }
+
+    cl::Program::Sources sources;
+    sources.emplace_back(file->source.data(), file->source.size());
+    program = cl::Program(context, sources);
+    cl_int error = program.build(std::vector<cl::Device>{device}, options.c_str());
+    if (error == CL_SUCCESS) {
+        std::cout << "Kernel program " << fileName << " build success\n";
+    }
+    return error;
+}
+
+cl::Program buildProgram(const cl::Context &context, const cl::Device &device, const std::string &fileName,
+                         const std::string &options) {
+    cl::Program program;
+    const cl_int error = tryBuildProgram(context, device, fileName, program, options);
+    if (error == CL_INVALID_VALUE && program() == nullptr) {
+        std::cerr << "Kernel file " << fileName << " is not embedded in the executable!\n";
+        std::exit(1);
+    }
+    if (error != CL_SUCCESS) {
+        std::cerr << "Error!\nBuild Status: " << program.getBuildInfo<CL_PROGRAM_BUILD_STATUS>(device)
+                  << "\nBuild Log:\n" << program.getBuildInfo<CL_PROGRAM_BUILD_LOG>(device) << std::endl;
+        std::exit(1);
+    }
+    return program;
+}
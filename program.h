@@ -0,0 +1,20 @@
+#pragma once
+
+#include <CL/opencl.hpp>
+#include <string>
+
+/**
+ * Builds an OpenCL program from a kernel file embedded into the executable at build time.
+ * Binaries and SPIR-V precompiled by CMake are preferred when the device accepts them and
+ * no extra build options are requested, otherwise the embedded source is compiled.
+ * Exits the application when the file is not embedded or the build fails.
+ **/
+cl::Program buildProgram(const cl::Context &context, const cl::Device &device, const std::string &fileName,
+                         const std::string &options = "");
+
+/**
+ * buildProgram without exiting: returns CL_INVALID_VALUE when the file is not embedded and
+ * the build's error when it fails, in which case program holds the failed build and its log.
+ **/
+cl_int tryBuildProgram(const cl::Context &context, const cl::Device &device, const std::string &fileName,
+                       cl::Program &program, const std::string &options = "");
@@ -0,0 +1,67 @@
+#include "protocol.h"
+
+#include <cerrno>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace protocol {
+
+    uint64_t payloadBytes(const RequestHeader &request) {
+        if (request.operation == static_cast<uint16_t>(Operation::AttachSharedMemory)) {
+            return request.count;
+        }
+        if (request.flags & SHARED_MEMORY) {
+            return sizeof(uint64_t) * (request.inputs + 1);
+        }
+        return sizeof(float) * request.count * request.inputs;
+    }
+
+    bool readAll(int fd, void *data, size_t bytes) {
+        auto *position = static_cast<char *>(data);
+        while (bytes > 0) {
+            ssize_t received = read(fd, position, bytes);
+            if (received < 0 && errno == EINTR) {
+                continue;
+            }
+            if (received <= 0) {
+                return false;
+            }
+            position += received;
+            bytes -= received;
+        }
+        return true;
+    }
+
+    bool writeAll(int fd, const void *data, size_t bytes) {
+        auto *position = static_cast<const char *>(data);
+        while (bytes > 0) {
+            // MSG_NOSIGNAL turns a closed peer into an error instead of SIGPIPE.
+            ssize_t sent = send(fd, position, bytes, MSG_NOSIGNAL);
+            if (sent < 0 && errno == EINTR) {
+                continue;
+            }
+            if (sent <= 0) {
+                return false;
+            }
+            position += sent;
+            bytes -= sent;
+        }
+        return true;
+    }
+
+    const char *statusName(Status status) {
+        switch (status) {
+            case Status::Ok:
+                return "ok";
+            case Status::UnknownOperation:
+                return "unknown operation";
+            case Status::BadRequest:
+                return "bad request";
+            case Status::DeviceError:
+                return "device error";
+            case Status::ConnectionError:
+                return "connection error";
+        }
+        return "unknown status";
+    }
+}
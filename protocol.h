@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * Binary framing spoken over the daemon's Unix domain socket. A client sends a RequestHeader
+ * followed by `inputs` arrays of `count` floats, the server answers with a ResponseHeader
+ * followed by `count` result floats. Fields are in host byte order, both ends share the machine.
+ *
+ * For large vectors a client can attach a POSIX shared memory object instead. Requests flagged
+ * SHARED_MEMORY then carry the byte offsets of the inputs and the output within it, the server
+ * computes directly on those pages and answers with an empty payload.
+ **/
+namespace protocol {
+
+    constexpr uint32_t MAGIC = 0x4c43504f;  // "OPCL"
+
+    // Operations the daemon serves, each backed by a registered kernel.
+    enum class Operation : uint16_t {
+        Vadd = 1,                       // c = a * x + y * x
+        AttachSharedMemory = 0x8000     // Payload is the `count` byte name of a shared memory object
+    };
+
+    // Payload holds `inputs` + 1 uint64_t byte offsets into the attached shared memory, output last. Vectors may
+    // share an offset but not partly overlap, such requests are answered with BadRequest.
+    constexpr uint32_t SHARED_MEMORY = 1;
+
+    enum class Status : uint16_t {
+        Ok = 0,
+        UnknownOperation,
+        BadRequest,
+        DeviceError,
+        ConnectionError     // Reported by the client only, never sent
+    };
+
+    struct RequestHeader {
+        uint32_t magic = MAGIC;
+        uint16_t operation = 0;
+        uint16_t inputs = 0;        // Arrays in the payload
+        uint64_t requestId = 0;     // Echoed in the response
+        uint64_t count = 0;         // Floats per array
+        float scalar = 0;
+        uint32_t flags = 0;
+    };
+
+    struct ResponseHeader {
+        uint32_t magic = MAGIC;
+        uint16_t status = 0;
+        uint16_t reserved = 0;
+        uint64_t requestId = 0;
+        uint64_t count = 0;         // Floats in the payload
+    };
+
+    static_assert(sizeof(RequestHeader) == 32 && sizeof(ResponseHeader) == 24);
+
+    uint64_t payloadBytes(const RequestHeader &request);
+
+    // Reads or writes exactly `bytes`, retrying short transfers and interrupted calls.
+    bool readAll(int fd, void *data, size_t bytes);
+
+    bool writeAll(int fd, const void *data, size_t bytes);
+
+    const char *statusName(Status status);
+}
@@ -0,0 +1,102 @@
+#include "quantize.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace {
+
+    // Smallest and largest integer of the format.
+    std::pair<int, int> range(InputFormat format) {
+        switch (format) {
+            case InputFormat::Int8:
+                return {INT8_MIN, INT8_MAX};
+            case InputFormat::UInt8:
+                return {0, UINT8_MAX};
+            case InputFormat::Int16:
+                return {INT16_MIN, INT16_MAX};
+        }
+        return {0, 0};
+    }
+
+    void store(InputFormat format, uint8_t *data, size_t index, int value) {
+        switch (format) {
+            case InputFormat::Int8:
+                data[index] = static_cast<uint8_t>(static_cast<int8_t>(value));
+                break;
+            case InputFormat::UInt8:
+                data[index] = static_cast<uint8_t>(value);
+                break;
+            case InputFormat::Int16: {
+                const auto narrowed = static_cast<int16_t>(value);
+                std::memcpy(data + 2 * index, &narrowed, sizeof(narrowed));
+                break;
+            }
+        }
+    }
+
+    int load(InputFormat format, const uint8_t *data, size_t index) {
+        switch (format) {
+            case InputFormat::Int8:
+                return static_cast<int8_t>(data[index]);
+            case InputFormat::UInt8:
+                return data[index];
+            case InputFormat::Int16: {
+                int16_t value;
+                std::memcpy(&value, data + 2 * index, sizeof(value));
+                return value;
+            }
+        }
+        return 0;
+    }
+}
+
+float QuantizedVector::value(size_t index) const {
+    const QuantizationBlock &block = blocks[index / QUANTIZATION_BLOCK];
+    // Same operations as the kernels, so the host reproduces what the device sees.
+    return static_cast<float>(load(format, data.data(), index)) * block.scale + block.offset;
+}
+
+std::string inputFormatName(InputFormat format) {
+    switch (format) {
+        case InputFormat::Int8:
+            return "int8";
+        case InputFormat::UInt8:
+            return "uint8";
+        case InputFormat::Int16:
+            return "int16";
+    }
+    return "";
+}
+
+size_t elementBytes(InputFormat format) {
+    return format == InputFormat::Int16 ? 2 : 1;
+}
+
+std::string quantizedKernelName(InputFormat format) {
+    return "vadd_" + inputFormatName(format);
+}
+
+QuantizedVector quantize(std::span<const float> values, InputFormat format) {
+    const auto [low, high] = range(format);
+    QuantizedVector quantized{format, values.size(), std::vector<uint8_t>(elementBytes(format) * values.size()), {}};
+    for (size_t begin = 0; begin < values.size(); begin += QUANTIZATION_BLOCK) {
+        const auto block = values.subspan(begin, std::min(QUANTIZATION_BLOCK, values.size() - begin));
+        const auto [min, max] = std::minmax_element(block.begin(), block.end());
+        // The lowest integer stands for the block's minimum and the highest for its maximum.
+        const float scale = (*max - *min) / static_cast<float>(high - low);
+        const float offset = *min - static_cast<float>(low) * scale;
+        quantized.blocks.push_back({scale, offset});
+        for (size_t i = 0; i < block.size(); i++) {
+            const long q = scale > 0 ? std::lround((block[i] - offset) / scale) : low;
+            store(format, quantized.data.data(), begin + i, static_cast<int>(std::clamp<long>(q, low, high)));
+        }
+    }
+    return quantized;
+}
+
+void dequantize(const QuantizedVector &quantized, std::span<float> values) {
+    for (size_t i = 0; i < quantized.size; i++) {
+        values[i] = quantized.value(i);
+    }
+}
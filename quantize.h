@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <vector>
+
+// Storage of quantised kernel inputs, see the vadd_int8, vadd_uint8 and vadd_int16 kernels.
+enum class InputFormat {
+    Int8,
+    UInt8,
+    Int16
+};
+
+// Elements sharing a scale and offset, must match QUANTIZATION_BLOCK in kernel.cl.
+constexpr size_t QUANTIZATION_BLOCK = 256;
+
+// Laid out like the float2 kernels read per block.
+struct QuantizationBlock {
+    float scale;
+    float offset;
+};
+
+/**
+ * Floats stored as 8 or 16 bit integers, element i standing for q[i] * scale + offset with the
+ * scale and offset of its block. Each block spans its own minimum to maximum, so the error is
+ * at most half a step of (max - min) / 255 for 8 bits and / 65535 for 16 bits.
+ **/
+struct QuantizedVector {
+    InputFormat format;
+    size_t size;
+    std::vector<uint8_t> data;      // size integers of the format, packed
+    std::vector<QuantizationBlock> blocks;
+
+    float value(size_t index) const;
+};
+
+std::string inputFormatName(InputFormat format);
+
+size_t elementBytes(InputFormat format);
+
+// The kernel computing vadd over inputs of the format.
+std::string quantizedKernelName(InputFormat format);
+
+QuantizedVector quantize(std::span<const float> values, InputFormat format);
+
+// The floats the device sees, into values of size quantized.size.
+void dequantize(const QuantizedVector &quantized, std::span<float> values);
@@ -0,0 +1,172 @@
+#include "ranking.h"
+#include "program.h"
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+
+namespace {
+
+    const std::string OPERATION = "vadd";
+    const std::string KERNEL_PROGRAM_FILE = "kernel.cl";
+    const int PROBE_REPEATS = 3;
+    const float SCALAR = 2.0f;
+
+    // Drivers are part of the key, an update can change the ranking. Probes run at the exact size, which is the key.
+    std::string cacheKey(const DeviceRank &rank, size_t elements) {
+        return OPERATION + "\t" + std::to_string(elements) + "\t" +
+               rank.device.getInfo<CL_DRIVER_VERSION>() + "\t" + rank.deviceName;
+    }
+
+    double capabilityOf(const cl::Device &device, size_t elements) {
+        if (device.getInfo<CL_DEVICE_MAX_MEM_ALLOC_SIZE>() < sizeof(float) * elements ||
+            device.getInfo<CL_DEVICE_GLOBAL_MEM_SIZE>() < 3 * sizeof(float) * elements) {
+            return 0;
+        }
+        return static_cast<double>(device.getInfo<CL_DEVICE_MAX_COMPUTE_UNITS>()) *
+               device.getInfo<CL_DEVICE_MAX_CLOCK_FREQUENCY>() *
+               std::max<cl_uint>(1, device.getInfo<CL_DEVICE_PREFERRED_VECTOR_WIDTH_FLOAT>());
+    }
+
+    // Best of PROBE_REPEATS vadds writing the inputs, running the kernel and reading the result, or 0 on errors.
+    double probe(const cl::Device &device, size_t elements) {
+        const size_t bytes = sizeof(float) * elements;
+        std::vector<float> x(elements, 1.0f), y(elements, 2.0f), c(elements);
+
+        cl_int error = CL_SUCCESS;
+        cl::Context context(device, nullptr, nullptr, nullptr, &error);
+        if (error != CL_SUCCESS) {
+            return 0;
+        }
+        // A compiler rejecting the kernels fails this device's probe, not the whole ranking.
+        cl::Program program;
+        if (tryBuildProgram(context, device, KERNEL_PROGRAM_FILE, program) != CL_SUCCESS) {
+            return 0;
+        }
+        cl::CommandQueue queue(context, device);
+        // Failed allocations show up as errors of the first enqueue using them.
+        cl::Buffer aBuf(context, CL_MEM_READ_ONLY, bytes);
+        cl::Buffer bBuf(context, CL_MEM_READ_ONLY, bytes);
+        cl::Buffer cBuf(context, CL_MEM_WRITE_ONLY, bytes);
+        cl::Kernel kernel(program, "vadd", &error);
+        if (error != CL_SUCCESS) {
+            return 0;
+        }
+        kernel.setArg(0, SCALAR);
+        kernel.setArg(1, aBuf);
+        kernel.setArg(2, bBuf);
+        kernel.setArg(3, cBuf);
+
+        auto best = std::chrono::duration<double>::max();
+        // The first round warms up the driver and is not counted.
+        for (int i = 0; i <= PROBE_REPEATS && error == CL_SUCCESS; i++) {
+            auto start_time = std::chrono::high_resolution_clock::now();
+            error = queue.enqueueWriteBuffer(aBuf, CL_FALSE, 0, bytes, x.data());
+            if (error == CL_SUCCESS) {
+                error = queue.enqueueWriteBuffer(bBuf, CL_FALSE, 0, bytes, y.data());
+            }
+            if (error == CL_SUCCESS) {
+                error = queue.enqueueNDRangeKernel(kernel, cl::NullRange, cl::NDRange(elements));
+            }
+            if (error == CL_SUCCESS) {
+                error = queue.enqueueReadBuffer(cBuf, CL_TRUE, 0, bytes, c.data());
+            }
+            if (i > 0) {
+                best = std::min<std::chrono::duration<double>>(best,
+                                                               std::chrono::high_resolution_clock::now() - start_time);
+            }
+        }
+        return error == CL_SUCCESS ? best.count() : 0;
+    }
+
+    // The file has one tab separated line per probe: operation, size, driver version, device name, seconds.
+    std::vector<std::pair<std::string, double>> loadProbes(const std::string &rankingFile) {
+        std::vector<std::pair<std::string, double>> probes;
+        std::ifstream file(rankingFile);
+        for (std::string line; std::getline(file, line);) {
+            const size_t split = line.rfind('\t');
+            // Failed probes saved by earlier versions are dropped, so those devices are probed again.
+            const double seconds = split == std::string::npos ? 0 : std::strtod(line.c_str() + split + 1, nullptr);
+            if (seconds > 0) {
+                probes.emplace_back(line.substr(0, split), seconds);
+            }
+        }
+        return probes;
+    }
+
+    void saveProbes(const std::string &rankingFile, const std::vector<std::pair<std::string, double>> &probes) {
+        std::ofstream file(rankingFile);
+        file << std::setprecision(17);
+        for (const auto &[key, seconds]: probes) {
+            file << key << "\t" << seconds << "\n";
+        }
+    }
+}
+
+std::vector<DeviceRank> rankDevices(size_t elements, cl_device_type type, const std::string &rankingFile) {
+    std::vector<cl::Platform> platforms;
+    cl::Platform::get(&platforms);
+
+    auto probes = loadProbes(rankingFile);
+    bool probed = false;
+    std::vector<DeviceRank> ranking;
+    for (const auto &platform: platforms) {
+        std::vector<cl::Device> devices;
+        platform.getDevices(type, &devices);
+        for (const auto &device: devices) {
+            DeviceRank rank{device, platform.getInfo<CL_PLATFORM_NAME>(), device.getInfo<CL_DEVICE_NAME>(),
+                            capabilityOf(device, elements), 0, false};
+            if (rank.capability > 0) {
+                const std::string key = cacheKey(rank, elements);
+                auto found = std::find_if(probes.begin(), probes.end(), [&](const auto &entry) {
+                    return entry.first == key;
+                });
+                if (found != probes.end()) {
+                    rank.probeSeconds = found->second;
+                    rank.cached = true;
+                } else {
+                    // Failures are not kept, they may be transient and the device is probed again next run.
+                    rank.probeSeconds = probe(device, elements);
+                    if (rank.probeSeconds > 0) {
+                        probes.emplace_back(key, rank.probeSeconds);
+                        probed = true;
+                    }
+                }
+            }
+            ranking.push_back(rank);
+        }
+    }
+    if (probed) {
+        saveProbes(rankingFile, probes);
+    }
+
+    std::stable_sort(ranking.begin(), ranking.end(), [](const DeviceRank &a, const DeviceRank &b) {
+        if ((a.probeSeconds > 0) != (b.probeSeconds > 0)) {
+            return a.probeSeconds > 0;
+        }
+        if (a.probeSeconds > 0) {
+            return a.probeSeconds < b.probeSeconds;
+        }
+        return a.capability > b.capability;
+    });
+    return ranking;
+}
+
+void printRanking(const std::vector<DeviceRank> &ranking, std::ostream &out) {
+    out << "Device ranking for " << OPERATION << ":\n";
+    for (size_t i = 0; i < ranking.size(); i++) {
+        const auto &rank = ranking[i];
+        std::ostringstream probe;
+        if (rank.probeSeconds > 0) {
+            probe << std::fixed << std::setprecision(1) << rank.probeSeconds * 1e6 << " us"
+                  << (rank.cached ? " (cached)" : "");
+        } else {
+            probe << (rank.capability > 0 ? "probe failed" : "vectors do not fit");
+        }
+        out << "  " << i + 1 << ". " << rank.deviceName << " on " << rank.platformName << ": " << probe.str()
+            << ", capability " << std::fixed << std::setprecision(0) << rank.capability << "\n";
+    }
+    out << std::flush;
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <CL/opencl.hpp>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// One device's entry in the ranking for vadd of a given size.
+struct DeviceRank {
+    cl::Device device;
+    std::string platformName;
+    std::string deviceName;
+    double capability;      // Compute units * clock in MHz * preferred float vector width, 0 if the vectors don't fit
+    double probeSeconds;    // Best end-to-end vadd of the ranked size including transfers, 0 if not measured
+    bool cached;            // probeSeconds came from the ranking file
+};
+
+/**
+ * Ranks the devices of `type` on all platforms for vadd on `elements` floats, fastest first.
+ * Devices are ordered by a short probe timing transfers and kernel together, which is run
+ * once per device, driver and vector size and then kept in rankingFile. Failed probes are
+ * not kept and run again next time; those devices follow, ordered by their capability from the
+ * properties printSystemInfo shows.
+ **/
+std::vector<DeviceRank> rankDevices(size_t elements, cl_device_type type, const std::string &rankingFile);
+
+void printRanking(const std::vector<DeviceRank> &ranking, std::ostream &out);
@@ -0,0 +1,72 @@
+#include "resources.h"
+
+#include <algorithm>
+#include <iomanip>
+
+namespace {
+
+    size_t roundUp(size_t value, size_t multiple) {
+        return (value + multiple - 1) / multiple * multiple;
+    }
+
+    KernelResources kernelResources(const cl::Program &program, const cl::Device &device, const std::string &name,
+                                    size_t localSize) {
+        cl::Kernel kernel(program, name.c_str());
+        KernelResources resources{name,
+                                  kernel.getWorkGroupInfo<CL_KERNEL_WORK_GROUP_SIZE>(device),
+                                  kernel.getWorkGroupInfo<CL_KERNEL_PREFERRED_WORK_GROUP_SIZE_MULTIPLE>(device),
+                                  kernel.getWorkGroupInfo<CL_KERNEL_PRIVATE_MEM_SIZE>(device),
+                                  kernel.getWorkGroupInfo<CL_KERNEL_LOCAL_MEM_SIZE>(device),
+                                  localSize, 0.0};
+        if (resources.localSize == 0) {
+            resources.localSize = resources.workGroupSize;
+        }
+        const size_t deviceItems = device.getInfo<CL_DEVICE_MAX_WORK_GROUP_SIZE>();
+        const size_t multiple = std::max<size_t>(resources.preferredMultiple, 1);
+        if (resources.localSize == 0 || deviceItems == 0) {
+            return resources;
+        }
+
+        // Whole work-groups only, at least one since the launch succeeds.
+        size_t groups = std::max<size_t>(resources.workGroupSize / resources.localSize, 1);
+        if (resources.localBytes > 0) {
+            groups = std::min<size_t>(groups, device.getInfo<CL_DEVICE_LOCAL_MEM_SIZE>() / resources.localBytes);
+        }
+        const size_t residentItems = groups * resources.localSize;
+        const double lanes = static_cast<double>(resources.localSize) / roundUp(resources.localSize, multiple);
+        resources.occupancy = std::min(1.0, static_cast<double>(residentItems) / deviceItems) * lanes;
+        return resources;
+    }
+}
+
+ProgramResources programResources(const cl::Program &program, const cl::Device &device,
+                                  const std::vector<std::string> &kernelNames, size_t localSize) {
+    ProgramResources resources;
+    // Built for the device of a single device context, so the only binary is the device's.
+    const auto binarySizes = program.getInfo<CL_PROGRAM_BINARY_SIZES>();
+    resources.binaryBytes = binarySizes.empty() ? 0 : binarySizes.front();
+    resources.buildOptions = program.getBuildInfo<CL_PROGRAM_BUILD_OPTIONS>(device);
+    resources.buildLog = program.getBuildInfo<CL_PROGRAM_BUILD_LOG>(device);
+    for (const auto &name: kernelNames) {
+        resources.kernels.push_back(kernelResources(program, device, name, localSize));
+    }
+    return resources;
+}
+
+void printProgramResources(std::ostream &out, const ProgramResources &resources) {
+    // Build logs often end with blank lines or hold nothing but whitespace.
+    const auto end = resources.buildLog.find_last_not_of(" \t\r\n");
+    out << "Program binary size (bytes): " << resources.binaryBytes
+        << "\nBuild options: " << (resources.buildOptions.empty() ? "(none)" : resources.buildOptions)
+        << "\nBuild log: " << (end == std::string::npos ? "(empty)" : resources.buildLog.substr(0, end + 1))
+        << "\n  " << std::left << std::setw(16) << "Kernel" << std::right << std::setw(12) << "Max group"
+        << std::setw(10) << "Multiple" << std::setw(14) << "Private (B)" << std::setw(12) << "Local (B)"
+        << std::setw(12) << "Local size" << std::setw(12) << "Occupancy" << "\n";
+    for (const auto &kernel: resources.kernels) {
+        out << "  " << std::left << std::setw(16) << kernel.name << std::right << std::setw(12) << kernel.workGroupSize
+            << std::setw(10) << kernel.preferredMultiple << std::setw(14) << kernel.privateBytes << std::setw(12)
+            << kernel.localBytes << std::setw(12) << kernel.localSize << std::fixed << std::setprecision(0)
+            << std::setw(11) << kernel.occupancy * 100 << "%\n";
+    }
+    out << std::defaultfloat;
+}
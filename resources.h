@@ -0,0 +1,36 @@
+#pragma once
+
+#include <CL/opencl.hpp>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// What the compiler made of one kernel for a device, and how well it fills a compute unit.
+struct KernelResources {
+    std::string name;
+    size_t workGroupSize;       // CL_KERNEL_WORK_GROUP_SIZE, lowered by drivers under register pressure
+    size_t preferredMultiple;   // CL_KERNEL_PREFERRED_WORK_GROUP_SIZE_MULTIPLE, the SIMD width in practice
+    cl_ulong privateBytes;      // per work-item
+    cl_ulong localBytes;        // per work-group
+    size_t localSize;           // the local size the estimate assumes
+    double occupancy;           // estimated fraction of the compute unit's work-item slots in use
+};
+
+struct ProgramResources {
+    size_t binaryBytes;
+    std::string buildOptions;
+    std::string buildLog;
+    std::vector<KernelResources> kernels;
+};
+
+/**
+ * Queries the built program and the given kernels of it on the device. Occupancy is estimated
+ * without vendor tools: the work-items resident per compute unit, limited by local memory and
+ * by the kernel's own work-group size limit, relative to the device's maximum work-group size,
+ * times the fraction of SIMD lanes the local size fills. A localSize of 0, where the driver
+ * picks, assumes CL_KERNEL_WORK_GROUP_SIZE.
+ **/
+ProgramResources programResources(const cl::Program &program, const cl::Device &device,
+                                  const std::vector<std::string> &kernelNames, size_t localSize);
+
+void printProgramResources(std::ostream &out, const ProgramResources &resources);
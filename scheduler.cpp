@@ -0,0 +1,99 @@
+#include "scheduler.h"
+#include "host.h"
+#include "program.h"
+
+#include <algorithm>
+#include <thread>
+
+namespace {
+
+    const std::string KERNEL_PROGRAM_FILE = "kernel.cl";
+    // Smallest chunk worth a kernel launch and its transfers.
+    const size_t MIN_CHUNK = 16'384;
+    // Chunks stay multiples of a cache line so workers never share one.
+    const size_t ALIGNMENT = 16;
+}
+
+ChunkScheduler::ChunkScheduler(const std::vector<cl::Device> &devices, unsigned hostThreads)
+        : hostThreads(hostThreads) {
+    for (const auto &device: devices) {
+        cl::Context context(device);
+        cl::Program program = buildProgram(context, device, KERNEL_PROGRAM_FILE);
+        deviceWorkers.push_back({context, cl::CommandQueue(context, device), cl::Kernel(program, "vadd")});
+        stats.push_back({device.getInfo<CL_DEVICE_NAME>()});
+    }
+    for (unsigned i = 0; i < hostThreads; i++) {
+        stats.push_back({"host worker " + std::to_string(i)});
+    }
+}
+
+const std::vector<WorkerStats> &ChunkScheduler::lastStats() const {
+    return stats;
+}
+
+bool ChunkScheduler::takeChunk(size_t size, size_t &begin, size_t &count) {
+    const size_t workers = stats.size();
+    begin = next.load();
+    do {
+        if (begin >= size) {
+            return false;
+        }
+        // Guided self-scheduling: half of an even share of what remains.
+        size_t remaining = size - begin;
+        count = std::max(MIN_CHUNK, remaining / (2 * workers)) / ALIGNMENT * ALIGNMENT;
+        count = std::min(count, remaining);
+    } while (!next.compare_exchange_weak(begin, begin + count));
+    return true;
+}
+
+void ChunkScheduler::vadd(float a, std::span<const float> x, std::span<const float> y,
+                          std::span<float> result) {
+    const size_t n = x.size();
+    next = 0;
+    for (auto &workerStats: stats) {
+        workerStats.elements = 0;
+        workerStats.chunks = 0;
+    }
+
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < deviceWorkers.size(); i++) {
+        threads.emplace_back(&ChunkScheduler::runDevice, this, i, a, x.data(), y.data(), result.data(), n);
+    }
+    for (size_t i = deviceWorkers.size(); i < stats.size(); i++) {
+        threads.emplace_back(&ChunkScheduler::runHost, this, i, a, x.data(), y.data(), result.data(), n);
+    }
+    for (auto &thread: threads) {
+        thread.join();
+    }
+}
+
+void ChunkScheduler::runDevice(size_t worker, float a, const float *x, const float *y, float *result, size_t n) {
+    auto &[context, queue, kernel] = deviceWorkers[worker];
+    size_t begin, count;
+    while (takeChunk(n, begin, count)) {
+        const size_t bytes = sizeof(float) * count;
+        cl::Buffer aBuf(context, CL_MEM_READ_ONLY, bytes);
+        cl::Buffer bBuf(context, CL_MEM_READ_ONLY, bytes);
+        cl::Buffer cBuf(context, CL_MEM_WRITE_ONLY, bytes);
+        queue.enqueueWriteBuffer(aBuf, CL_FALSE, 0, bytes, x + begin);
+        queue.enqueueWriteBuffer(bBuf, CL_FALSE, 0, bytes, y + begin);
+        kernel.setArg(0, a);
+        kernel.setArg(1, aBuf);
+        kernel.setArg(2, bBuf);
+        kernel.setArg(3, cBuf);
+        queue.enqueueNDRangeKernel(kernel, cl::NullRange, cl::NDRange(count));
+        queue.enqueueReadBuffer(cBuf, CL_TRUE, 0, bytes, result + begin);
+
+        stats[worker].elements += count;
+        stats[worker].chunks++;
+    }
+}
+
+void ChunkScheduler::runHost(size_t worker, float a, const float *x, const float *y, float *result, size_t n) {
+    size_t begin, count;
+    while (takeChunk(n, begin, count)) {
+        vaddOnHost(a, x + begin, y + begin, result + begin, count);
+        stats[worker].elements += count;
+        stats[worker].chunks++;
+    }
+}
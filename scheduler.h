@@ -0,0 +1,48 @@
+#pragma once
+
+#include <CL/opencl.hpp>
+#include <atomic>
+#include <span>
+#include <string>
+#include <vector>
+
+// Work done by one device queue or host worker in the last ChunkScheduler::vadd call.
+struct WorkerStats {
+    std::string name;
+    size_t elements = 0;
+    size_t chunks = 0;
+};
+
+/**
+ * Computes vadd over chunks taken from a shared queue by one thread per OpenCL device and by
+ * host worker threads. Chunks are guided: each takes a share of what is left, so they shrink
+ * towards the tail and a slow or throttled worker holds up the others for one small chunk only.
+ **/
+class ChunkScheduler {
+public:
+    ChunkScheduler(const std::vector<cl::Device> &devices, unsigned hostThreads);
+
+    void vadd(float a, std::span<const float> x, std::span<const float> y, std::span<float> result);
+
+    // Devices first, in constructor order, then host workers.
+    const std::vector<WorkerStats> &lastStats() const;
+
+private:
+    struct DeviceWorker {
+        cl::Context context;
+        cl::CommandQueue queue;
+        cl::Kernel kernel;
+    };
+
+    // Takes the next chunk of [0, size) into begin and count, false when none is left.
+    bool takeChunk(size_t size, size_t &begin, size_t &count);
+
+    void runDevice(size_t worker, float a, const float *x, const float *y, float *result, size_t n);
+
+    void runHost(size_t worker, float a, const float *x, const float *y, float *result, size_t n);
+
+    std::vector<DeviceWorker> deviceWorkers;
+    unsigned hostThreads;
+    std::atomic<size_t> next = 0;
+    std::vector<WorkerStats> stats;
+};
@@ -0,0 +1,602 @@
+#include "server.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+namespace {
+
+    // How often the accept loop checks whether it should stop.
+    const int POLL_INTERVAL_MS = 200;
+    // Buffers wrapping shared memory kept per connection before they are recreated.
+    const size_t MAX_SHARED_BUFFERS = 64;
+    // Longest shared memory object name accepted, NAME_MAX on Linux.
+    const uint64_t MAX_SHARED_NAME = 255;
+
+    // Reads and drops a payload the server will not process, so the next header lines up.
+    bool skip(int fd, uint64_t bytes) {
+        char discard[4096];
+        while (bytes > 0) {
+            size_t chunk = std::min<uint64_t>(bytes, sizeof(discard));
+            if (!protocol::readAll(fd, discard, chunk)) {
+                return false;
+            }
+            bytes -= chunk;
+        }
+        return true;
+    }
+
+    bool respond(int fd, uint64_t requestId, protocol::Status status, const float *data, uint64_t count) {
+        protocol::ResponseHeader response;
+        response.status = static_cast<uint16_t>(status);
+        response.requestId = requestId;
+        response.count = count;
+        return protocol::writeAll(fd, &response, sizeof(response)) &&
+               protocol::writeAll(fd, data, sizeof(float) * count);
+    }
+}
+
+ComputeServer::ComputeServer(const cl::Context &context, const cl::Device &device, const cl::Program &program,
+                             std::string socketPath)
+        : context(context), device(device), program(program), socketPath(std::move(socketPath)) {
+}
+
+void ComputeServer::registerKernel(protocol::Operation operation, const std::string &kernelName, unsigned inputs) {
+    registerKernel(operation, kernelName, "", inputs);
+}
+
+void ComputeServer::registerKernel(protocol::Operation operation, const std::string &kernelName,
+                                   const std::string &segmentedKernelName, unsigned inputs) {
+    kernels[operation] = {kernelName, segmentedKernelName, inputs};
+}
+
+void ComputeServer::setCoalescing(const CoalescingConfig &config) {
+    coalescing = config;
+}
+
+CoalescingStats ComputeServer::coalescingStats() {
+    std::lock_guard lock(pendingMutex);
+    return stats;
+}
+
+void ComputeServer::stop() {
+    stopping = true;
+}
+
+bool ComputeServer::run() {
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    if (socketPath.size() >= sizeof(address.sun_path)) {
+        std::cerr << "Socket path " << socketPath << " is too long" << std::endl;
+        return false;
+    }
+    std::strncpy(address.sun_path, socketPath.c_str(), sizeof(address.sun_path) - 1);
+
+    int listener = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    unlink(socketPath.c_str());
+    if (listener < 0 || bind(listener, reinterpret_cast<sockaddr *>(&address), sizeof(address)) != 0 ||
+        listen(listener, SOMAXCONN) != 0) {
+        std::cerr << "Cannot listen on " << socketPath << ": " << std::strerror(errno) << std::endl;
+        if (listener >= 0) {
+            close(listener);
+        }
+        return false;
+    }
+    std::cout << "Serving on " << socketPath << std::endl;
+
+    std::thread coalescer;
+    if (coalescing.enabled) {
+        coalescerStopping = false;
+        coalescer = std::thread(&ComputeServer::runCoalescer, this);
+    }
+
+    while (!stopping) {
+        pollfd listening{listener, POLLIN, 0};
+        if (poll(&listening, 1, POLL_INTERVAL_MS) <= 0) {
+            continue;
+        }
+        int connection = accept4(listener, nullptr, nullptr, SOCK_CLOEXEC);
+        if (connection < 0) {
+            continue;
+        }
+        std::lock_guard lock(connectionsMutex);
+        connections.insert(connection);
+        std::thread(&ComputeServer::serve, this, connection).detach();
+    }
+
+    close(listener);
+    unlink(socketPath.c_str());
+
+    // Wake the connection threads blocked in read and wait until all of them are done.
+    std::unique_lock lock(connectionsMutex);
+    for (int connection: connections) {
+        shutdown(connection, SHUT_RDWR);
+    }
+    connectionsClosed.wait(lock, [this] { return connections.empty(); });
+    lock.unlock();
+
+    if (coalescer.joinable()) {
+        {
+            std::lock_guard pendingLock(pendingMutex);
+            coalescerStopping = true;
+        }
+        pendingArrived.notify_all();
+        coalescer.join();
+        coalescingStats().print(std::cout);
+    }
+    std::cout << "Server stopped" << std::endl;
+    return true;
+}
+
+void ComputeServer::serve(int connection) {
+    Session session(cl::CommandQueue(context, device));
+    const uint64_t maxCount = device.getInfo<CL_DEVICE_MAX_MEM_ALLOC_SIZE>() / sizeof(float);
+
+    protocol::RequestHeader request;
+    while (protocol::readAll(connection, &request, sizeof(request)) && request.magic == protocol::MAGIC) {
+        const auto operation = static_cast<protocol::Operation>(request.operation);
+        const auto registered = kernels.find(operation);
+        const bool isShared = request.flags & protocol::SHARED_MEMORY;
+
+        // Requests which end here still have to consume their payload to keep the framing.
+        auto status = protocol::Status::Ok;
+        bool consumed = false;
+        if (operation == protocol::Operation::AttachSharedMemory && request.count <= MAX_SHARED_NAME) {
+            std::string name(request.count, '\0');
+            if (!protocol::readAll(connection, name.data(), name.size())) {
+                break;
+            }
+            status = attach(session, name);
+            consumed = true;
+        } else if (operation == protocol::Operation::AttachSharedMemory) {
+            status = protocol::Status::BadRequest;
+        } else if (registered == kernels.end()) {
+            status = protocol::Status::UnknownOperation;
+        } else if (request.inputs != registered->second.inputs || request.count > maxCount) {
+            status = protocol::Status::BadRequest;
+        }
+        if (status != protocol::Status::Ok || consumed) {
+            if ((!consumed && !skip(connection, protocol::payloadBytes(request))) ||
+                !respond(connection, request.requestId, status, nullptr, 0)) {
+                break;
+            }
+            continue;
+        }
+
+        session.payload.resize((protocol::payloadBytes(request) + sizeof(float) - 1) / sizeof(float));
+        if (!protocol::readAll(connection, session.payload.data(), protocol::payloadBytes(request))) {
+            break;
+        }
+
+        if (!isShared && coalescing.enabled && !registered->second.segmentedName.empty() &&
+            request.count <= coalescing.maxRequestElements) {
+            status = coalesce(session, request);
+            if (!respond(connection, request.requestId, status, session.result.data(),
+                         status == protocol::Status::Ok ? request.count : 0)) {
+                break;
+            }
+            continue;
+        }
+
+        cl_int error = CL_SUCCESS;
+        auto instance = session.kernels.find(operation);
+        if (instance == session.kernels.end()) {
+            cl::Kernel kernel(program, registered->second.name.c_str(), &error);
+            instance = session.kernels.emplace(operation, kernel).first;
+        }
+        if (error == CL_SUCCESS) {
+            status = isShared ? runShared(session, instance->second, request)
+                              : runCopied(session, instance->second, request);
+        } else {
+            status = protocol::Status::DeviceError;
+        }
+
+        if (status == protocol::Status::DeviceError) {
+            // Drop the kernel and buffers, they may be what failed.
+            session.kernels.erase(operation);
+            session.capacity = 0;
+            session.sharedBufs.clear();
+        }
+        const bool hasResult = status == protocol::Status::Ok && !isShared;
+        if (!respond(connection, request.requestId, status, session.result.data(),
+                     hasResult ? request.count : 0)) {
+            break;
+        }
+    }
+
+    session.detach();
+    close(connection);
+    std::lock_guard lock(connectionsMutex);
+    connections.erase(connection);
+    connectionsClosed.notify_all();
+}
+
+protocol::Status ComputeServer::attach(Session &session, const std::string &name) {
+    session.detach();
+    int shm = shm_open(name.c_str(), O_RDWR, 0);
+    if (shm < 0) {
+        return protocol::Status::BadRequest;
+    }
+    struct stat info{};
+    void *mapped = fstat(shm, &info) == 0 && info.st_size > 0
+                   ? mmap(nullptr, info.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, shm, 0) : MAP_FAILED;
+    close(shm);
+    if (mapped == MAP_FAILED) {
+        return protocol::Status::BadRequest;
+    }
+    session.shared = static_cast<char *>(mapped);
+    session.sharedBytes = info.st_size;
+    return protocol::Status::Ok;
+}
+
+protocol::Status ComputeServer::runCopied(Session &session, cl::Kernel &kernel,
+                                          const protocol::RequestHeader &request) {
+    const size_t count = request.count;
+    const size_t bytes = sizeof(float) * count;
+    session.result.resize(count);
+    if (count == 0) {
+        return protocol::Status::Ok;
+    }
+
+    // Buffers only grow, so a steady stream of requests allocates nothing.
+    cl_int error = CL_SUCCESS;
+    if (count > session.capacity || session.inputBufs.size() < request.inputs) {
+        session.capacity = std::max(session.capacity, count);
+        session.inputBufs.resize(std::max<size_t>(session.inputBufs.size(), request.inputs));
+        for (auto &inputBuf: session.inputBufs) {
+            if (error == CL_SUCCESS) {
+                inputBuf = cl::Buffer(context, CL_MEM_READ_ONLY, sizeof(float) * session.capacity, nullptr, &error);
+            }
+        }
+        if (error == CL_SUCCESS) {
+            session.outputBuf = cl::Buffer(context, CL_MEM_WRITE_ONLY, sizeof(float) * session.capacity, nullptr,
+                                           &error);
+        }
+    }
+
+    kernel.setArg(0, request.scalar);
+    for (unsigned i = 0; i < request.inputs && error == CL_SUCCESS; i++) {
+        kernel.setArg(i + 1, session.inputBufs[i]);
+        error = session.queue.enqueueWriteBuffer(session.inputBufs[i], CL_FALSE, 0, bytes,
+                                                 session.payload.data() + i * count);
+    }
+    kernel.setArg(request.inputs + 1, session.outputBuf);
+    if (error == CL_SUCCESS) {
+        error = session.queue.enqueueNDRangeKernel(kernel, cl::NullRange, cl::NDRange(count));
+    }
+    if (error == CL_SUCCESS) {
+        error = session.queue.enqueueReadBuffer(session.outputBuf, CL_TRUE, 0, bytes, session.result.data());
+    }
+    if (error != CL_SUCCESS) {
+        std::cerr << "Request " << request.requestId << " failed with OpenCL error " << error << std::endl;
+        return protocol::Status::DeviceError;
+    }
+    return protocol::Status::Ok;
+}
+
+protocol::Status ComputeServer::runShared(Session &session, cl::Kernel &kernel,
+                                          const protocol::RequestHeader &request) {
+    const size_t bytes = sizeof(float) * request.count;
+    std::vector<uint64_t> offsets(request.inputs + 1);
+    std::memcpy(offsets.data(), session.payload.data(), sizeof(uint64_t) * offsets.size());
+    for (uint64_t offset: offsets) {
+        if (session.shared == nullptr || offset % sizeof(float) != 0 || offset > session.sharedBytes ||
+            bytes > session.sharedBytes - offset) {
+            return protocol::Status::BadRequest;
+        }
+    }
+    // Vectors at the same offset share one buffer, partly overlapping ones would alias separate buffers.
+    for (size_t i = 0; i < offsets.size(); i++) {
+        for (size_t j = i + 1; j < offsets.size(); j++) {
+            const uint64_t distance = offsets[i] > offsets[j] ? offsets[i] - offsets[j] : offsets[j] - offsets[i];
+            if (distance != 0 && distance < bytes) {
+                return protocol::Status::BadRequest;
+            }
+        }
+    }
+    if (request.count == 0) {
+        return protocol::Status::Ok;
+    }
+
+    // Wraps the client's pages directly, zero-copy on devices sharing host memory. Failed buffers are not kept.
+    cl_int error = CL_SUCCESS;
+    auto wrap = [&](uint64_t offset) {
+        auto found = session.sharedBufs.find({offset, bytes});
+        if (found != session.sharedBufs.end()) {
+            return found->second;
+        }
+        cl_int created = CL_SUCCESS;
+        cl::Buffer buffer(context, CL_MEM_READ_WRITE | CL_MEM_USE_HOST_PTR, bytes, session.shared + offset, &created);
+        if (created != CL_SUCCESS) {
+            error = created;
+            return buffer;
+        }
+        if (session.sharedBufs.size() >= MAX_SHARED_BUFFERS) {
+            session.sharedBufs.clear();
+        }
+        session.sharedBufs.emplace(std::pair{offset, bytes}, buffer);
+        return buffer;
+    };
+
+    std::vector<cl::Buffer> inputBufs;
+    for (unsigned i = 0; i < request.inputs; i++) {
+        inputBufs.push_back(wrap(offsets[i]));
+    }
+    cl::Buffer outputBuf = wrap(offsets.back());
+    // The client rewrote the inputs since the last request without mapping them, so a runtime keeping a device
+    // copy of the kept buffers would compute on stale values. Mapping them for writing and unmapping syncs it.
+    for (auto &buffer: inputBufs) {
+        void *mapped = nullptr;
+        if (error == CL_SUCCESS) {
+            mapped = session.queue.enqueueMapBuffer(buffer, CL_FALSE, CL_MAP_WRITE_INVALIDATE_REGION, 0, bytes,
+                                                    nullptr, nullptr, &error);
+        }
+        if (error == CL_SUCCESS) {
+            error = session.queue.enqueueUnmapMemObject(buffer, mapped);
+        }
+    }
+    if (error == CL_SUCCESS) {
+        kernel.setArg(0, request.scalar);
+        for (unsigned i = 0; i < request.inputs; i++) {
+            kernel.setArg(i + 1, inputBufs[i]);
+        }
+        kernel.setArg(request.inputs + 1, outputBuf);
+    }
+
+    if (error == CL_SUCCESS) {
+        error = session.queue.enqueueNDRangeKernel(kernel, cl::NullRange, cl::NDRange(request.count));
+    }
+    // Mapping makes the results visible in the client's pages, on host devices without a copy.
+    void *mapped = nullptr;
+    if (error == CL_SUCCESS) {
+        mapped = session.queue.enqueueMapBuffer(outputBuf, CL_TRUE, CL_MAP_READ, 0, bytes, nullptr, nullptr, &error);
+    }
+    if (error == CL_SUCCESS) {
+        error = session.queue.enqueueUnmapMemObject(outputBuf, mapped);
+    }
+    if (error == CL_SUCCESS) {
+        error = session.queue.finish();
+    }
+    if (error != CL_SUCCESS) {
+        std::cerr << "Request " << request.requestId << " failed with OpenCL error " << error << std::endl;
+        return protocol::Status::DeviceError;
+    }
+    return protocol::Status::Ok;
+}
+
+protocol::Status ComputeServer::coalesce(Session &session, const protocol::RequestHeader &request) {
+    session.result.resize(request.count);
+    PendingRequest waiting{static_cast<protocol::Operation>(request.operation), request, session.payload.data(),
+                           session.result.data(), std::chrono::steady_clock::now()};
+
+    std::unique_lock lock(pendingMutex);
+    pending.push_back(&waiting);
+    pendingArrived.notify_all();
+    pendingDone.wait(lock, [&waiting] { return waiting.done; });
+    return waiting.status;
+}
+
+ComputeServer::Flush ComputeServer::flushReason(std::chrono::steady_clock::time_point &checkAgain) {
+    const auto now = std::chrono::steady_clock::now();
+    const PendingRequest &oldest = *pending.front();
+    if (coalescerStopping) {
+        return Flush::Full;
+    }
+
+    size_t requests = 0;
+    size_t elements = 0;
+    for (const auto *request: pending) {
+        if (request->operation == oldest.operation) {
+            requests++;
+            elements += request->header.count;
+        }
+    }
+    if (requests >= coalescing.maxRequests || elements >= coalescing.maxElements) {
+        return Flush::Full;
+    }
+
+    // Leave the launch as much time as a batch of this size took so far.
+    const auto launch = std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+            std::chrono::duration<double>(batchModel.predict(static_cast<double>(elements))));
+    const auto windowEnd = oldest.arrival + coalescing.window;
+    const auto latestLaunch = oldest.arrival + coalescing.deadline - launch;
+    if (now >= latestLaunch && latestLaunch < windowEnd) {
+        return Flush::Deadline;
+    }
+    if (now >= windowEnd) {
+        return Flush::Window;
+    }
+    checkAgain = std::min(windowEnd, latestLaunch);
+    return Flush::None;
+}
+
+void ComputeServer::runCoalescer() {
+    Session session(cl::CommandQueue(context, device));
+    std::unique_lock lock(pendingMutex);
+    while (true) {
+        pendingArrived.wait(lock, [this] { return !pending.empty() || coalescerStopping; });
+        if (pending.empty()) {
+            break;
+        }
+
+        auto checkAgain = std::chrono::steady_clock::now();
+        Flush flush;
+        while ((flush = flushReason(checkAgain)) == Flush::None) {
+            pendingArrived.wait_until(lock, checkAgain);
+        }
+
+        // The oldest request always goes, followed by later ones of its operation that still fit.
+        const protocol::Operation operation = pending.front()->operation;
+        std::vector<PendingRequest *> batch;
+        std::deque<PendingRequest *> remaining;
+        size_t elements = 0;
+        for (auto *request: pending) {
+            if (request->operation == operation && batch.size() < coalescing.maxRequests &&
+                (batch.empty() || elements + request->header.count <= coalescing.maxElements)) {
+                batch.push_back(request);
+                elements += request->header.count;
+            } else {
+                remaining.push_back(request);
+            }
+        }
+        pending.swap(remaining);
+
+        lock.unlock();
+        const auto launched = std::chrono::steady_clock::now();
+        const auto status = runBatch(session, batch, elements);
+        const auto answered = std::chrono::steady_clock::now();
+        lock.lock();
+
+        stats.batches++;
+        stats.requests += batch.size();
+        stats.elements += elements;
+        stats.fullFlushes += flush == Flush::Full;
+        stats.windowFlushes += flush == Flush::Window;
+        stats.deadlineFlushes += flush == Flush::Deadline;
+        stats.launchedSeconds += std::chrono::duration<double>(answered - launched).count();
+        if (status == protocol::Status::Ok) {
+            batchModel.add(static_cast<double>(elements), std::chrono::duration<double>(answered - launched).count());
+        }
+        for (auto *request: batch) {
+            stats.queuedSeconds += std::chrono::duration<double>(launched - request->arrival).count();
+            stats.deadlineMisses += answered > request->arrival + coalescing.deadline;
+            request->status = status;
+            request->done = true;
+        }
+        pendingDone.notify_all();
+    }
+}
+
+protocol::Status ComputeServer::runBatch(Session &session, const std::vector<PendingRequest *> &batch,
+                                         size_t elements) {
+    const auto operation = batch.front()->operation;
+    const unsigned inputs = kernels.at(operation).inputs;
+    const size_t bytes = sizeof(float) * elements;
+
+    // Inputs go back to back per input, so each of them is one transfer.
+    session.scalars.clear();
+    session.starts.clear();
+    session.payload.resize(inputs * elements);
+    session.result.resize(elements);
+    size_t start = 0;
+    for (const auto *request: batch) {
+        const size_t count = request->header.count;
+        for (unsigned i = 0; i < inputs; i++) {
+            std::copy_n(request->payload + i * count, count, session.payload.data() + i * elements + start);
+        }
+        session.scalars.push_back(request->header.scalar);
+        session.starts.push_back(static_cast<cl_uint>(start));
+        start += count;
+    }
+    session.starts.push_back(static_cast<cl_uint>(elements));
+    if (elements == 0) {
+        return protocol::Status::Ok;
+    }
+
+    cl_int error = CL_SUCCESS;
+    auto instance = session.kernels.find(operation);
+    if (instance == session.kernels.end()) {
+        cl::Kernel kernel(program, kernels.at(operation).segmentedName.c_str(), &error);
+        instance = session.kernels.emplace(operation, kernel).first;
+    }
+    if (error == CL_SUCCESS && (elements > session.capacity || session.inputBufs.size() < inputs)) {
+        session.capacity = std::max(session.capacity, elements);
+        session.inputBufs.resize(std::max<size_t>(session.inputBufs.size(), inputs));
+        for (auto &inputBuf: session.inputBufs) {
+            if (error == CL_SUCCESS) {
+                inputBuf = cl::Buffer(context, CL_MEM_READ_ONLY, sizeof(float) * session.capacity, nullptr, &error);
+            }
+        }
+        if (error == CL_SUCCESS) {
+            session.outputBuf = cl::Buffer(context, CL_MEM_WRITE_ONLY, sizeof(float) * session.capacity, nullptr,
+                                           &error);
+        }
+    }
+    if (error == CL_SUCCESS && session.starts.size() > session.segmentCapacity) {
+        session.segmentCapacity = std::max(session.starts.size(), coalescing.maxRequests + 1);
+        session.scalarsBuf = cl::Buffer(context, CL_MEM_READ_ONLY, sizeof(float) * session.segmentCapacity, nullptr,
+                                        &error);
+        if (error == CL_SUCCESS) {
+            session.startsBuf = cl::Buffer(context, CL_MEM_READ_ONLY, sizeof(cl_uint) * session.segmentCapacity,
+                                           nullptr, &error);
+        }
+    }
+
+    cl::Kernel &kernel = instance->second;
+    if (error == CL_SUCCESS) {
+        error = session.queue.enqueueWriteBuffer(session.scalarsBuf, CL_FALSE, 0, sizeof(float) * batch.size(),
+                                                 session.scalars.data());
+    }
+    if (error == CL_SUCCESS) {
+        error = session.queue.enqueueWriteBuffer(session.startsBuf, CL_FALSE, 0,
+                                                 sizeof(cl_uint) * session.starts.size(), session.starts.data());
+    }
+    if (error == CL_SUCCESS) {
+        kernel.setArg(0, session.scalarsBuf);
+        kernel.setArg(1, session.startsBuf);
+        kernel.setArg(2, static_cast<cl_uint>(batch.size()));
+        for (unsigned i = 0; i < inputs && error == CL_SUCCESS; i++) {
+            kernel.setArg(i + 3, session.inputBufs[i]);
+            error = session.queue.enqueueWriteBuffer(session.inputBufs[i], CL_FALSE, 0, bytes,
+                                                     session.payload.data() + i * elements);
+        }
+        kernel.setArg(inputs + 3, session.outputBuf);
+    }
+    if (error == CL_SUCCESS) {
+        error = session.queue.enqueueNDRangeKernel(kernel, cl::NullRange, cl::NDRange(elements));
+    }
+    if (error == CL_SUCCESS) {
+        error = session.queue.enqueueReadBuffer(session.outputBuf, CL_TRUE, 0, bytes, session.result.data());
+    }
+    if (error != CL_SUCCESS) {
+        std::cerr << "Batch of " << batch.size() << " requests failed with OpenCL error " << error << std::endl;
+        // Drop the kernel and buffers, they may be what failed.
+        session.kernels.erase(operation);
+        session.capacity = 0;
+        session.segmentCapacity = 0;
+        return protocol::Status::DeviceError;
+    }
+
+    // Fan the packed output back out to the connections.
+    start = 0;
+    for (auto *request: batch) {
+        std::copy_n(session.result.data() + start, request->header.count, request->result);
+        start += request->header.count;
+    }
+    return protocol::Status::Ok;
+}
+
+void CoalescingStats::print(std::ostream &out) const {
+    if (batches == 0) {
+        out << "Coalescing: no batches\n";
+        return;
+    }
+    out << "Coalescing: " << requests << " requests in " << batches << " batches, " << std::fixed
+        << std::setprecision(1) << static_cast<double>(requests) / batches << " requests and "
+        << static_cast<double>(elements) / batches << " elements per batch\n"
+        << "  flushes: " << fullFlushes << " full, " << windowFlushes << " window, " << deadlineFlushes
+        << " deadline\n"
+        << "  queued " << std::setprecision(2) << queuedSeconds / requests * 1e6 << " us per request, launch "
+        << launchedSeconds / batches * 1e6 << " us per batch, " << deadlineMisses << " deadline misses\n";
+}
+
+void ComputeServer::Session::detach() {
+    sharedBufs.clear();
+    if (shared != nullptr) {
+        queue.finish();
+        munmap(shared, sharedBytes);
+        shared = nullptr;
+        sharedBytes = 0;
+    }
+}
@@ -0,0 +1,175 @@
+#pragma once
+
+#include "dispatcher.h"
+#include "protocol.h"
+
+#include <CL/opencl.hpp>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <ostream>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+/**
+ * Knobs of the stage packing small copied requests of all connections into one launch.
+ * A batch is flushed once it holds maxRequests or maxElements, `window` after its first
+ * request arrived, or early enough that its oldest request still meets `deadline`.
+ **/
+struct CoalescingConfig {
+    bool enabled = false;
+    std::chrono::microseconds window{200};
+    std::chrono::microseconds deadline{2000};
+    size_t maxRequests = 64;
+    size_t maxElements = 1 << 20;
+    size_t maxRequestElements = 1 << 16;    // Larger requests fill the device alone and skip the stage
+};
+
+struct CoalescingStats {
+    uint64_t batches = 0;
+    uint64_t requests = 0;
+    uint64_t elements = 0;
+    uint64_t fullFlushes = 0;
+    uint64_t windowFlushes = 0;
+    uint64_t deadlineFlushes = 0;
+    uint64_t deadlineMisses = 0;    // Requests answered after their deadline
+    double queuedSeconds = 0;       // Summed over requests, from arrival to their batch's launch
+    double launchedSeconds = 0;     // Summed over batches, from launch to results
+
+    void print(std::ostream &out) const;
+};
+
+/**
+ * Serves kernel requests from local clients over a Unix domain socket, see protocol.h.
+ * The context and program are created once by the caller and shared by all connections.
+ * Each connection gets its own command queue, kernels and device buffers, which are
+ * kept and only grown between requests, and may attach a shared memory region whose
+ * pages are wrapped as CL_MEM_USE_HOST_PTR buffers instead of copying payloads.
+ * Optionally, small copied requests of all connections are coalesced into one launch
+ * by a separate thread with its own queue, see CoalescingConfig.
+ **/
+class ComputeServer {
+public:
+    ComputeServer(const cl::Context &context, const cl::Device &device, const cl::Program &program,
+                  std::string socketPath);
+
+    /**
+     * Makes `operation` run `kernelName` from the program. The kernel must take the request's
+     * scalar, then `inputs` float buffers and finally the float output buffer.
+     **/
+    void registerKernel(protocol::Operation operation, const std::string &kernelName, unsigned inputs);
+
+    /**
+     * Like above, and lets requests of `operation` be coalesced with `segmentedKernelName`. It takes
+     * the scalars, the uint start of each request plus the total, the number of requests, then the
+     * inputs and the output of all requests packed back to back, see vadd_segmented.
+     **/
+    void registerKernel(protocol::Operation operation, const std::string &kernelName,
+                        const std::string &segmentedKernelName, unsigned inputs);
+
+    // Call before run().
+    void setCoalescing(const CoalescingConfig &config);
+
+    CoalescingStats coalescingStats();
+
+    // Accepts clients until stop() is called, then closes all connections. False if the socket cannot be opened.
+    bool run();
+
+    // Safe to call from a signal handler.
+    void stop();
+
+private:
+    struct RegisteredKernel {
+        std::string name;
+        std::string segmentedName;
+        unsigned inputs;
+    };
+
+    // A request waiting in a connection thread for the coalescing stage to answer it.
+    struct PendingRequest {
+        protocol::Operation operation;
+        const protocol::RequestHeader &header;
+        const float *payload;
+        float *result;
+        std::chrono::steady_clock::time_point arrival;
+        protocol::Status status = protocol::Status::Ok;
+        bool done = false;
+    };
+
+    enum class Flush {
+        None, Full, Window, Deadline
+    };
+
+    // State one connection keeps between its requests.
+    struct Session {
+        explicit Session(cl::CommandQueue queue) : queue(std::move(queue)) {}
+
+        cl::CommandQueue queue;
+        std::map<protocol::Operation, cl::Kernel> kernels;
+        std::vector<cl::Buffer> inputBufs;
+        cl::Buffer outputBuf;
+        size_t capacity = 0;    // Floats each of the buffers above holds
+        std::vector<float> payload;
+        std::vector<float> result;
+
+        char *shared = nullptr;
+        size_t sharedBytes = 0;
+        std::map<std::pair<uint64_t, uint64_t>, cl::Buffer> sharedBufs;    // By offset and size in shared
+
+        // Segment tables of the coalescing stage, whose session holds the packed batch above.
+        std::vector<float> scalars;
+        std::vector<cl_uint> starts;
+        cl::Buffer scalarsBuf;
+        cl::Buffer startsBuf;
+        size_t segmentCapacity = 0;
+
+        void detach();
+    };
+
+    void serve(int connection);
+
+    protocol::Status attach(Session &session, const std::string &name);
+
+    // Runs a request whose inputs came in the payload, leaving the output in session.result.
+    protocol::Status runCopied(Session &session, cl::Kernel &kernel, const protocol::RequestHeader &request);
+
+    // Runs a request on arrays in the session's shared memory, leaving the output there too.
+    protocol::Status runShared(Session &session, cl::Kernel &kernel, const protocol::RequestHeader &request);
+
+    // Hands a copied request to the coalescing stage and waits for its output in session.result.
+    protocol::Status coalesce(Session &session, const protocol::RequestHeader &request);
+
+    // Body of the thread running the coalescing stage.
+    void runCoalescer();
+
+    // Whether the pending batch led by the oldest request must go now, else when to check again.
+    Flush flushReason(std::chrono::steady_clock::time_point &checkAgain);
+
+    // Launches `batch` as one segmented kernel and fills in the results of its requests.
+    protocol::Status runBatch(Session &session, const std::vector<PendingRequest *> &batch, size_t elements);
+
+    cl::Context context;
+    cl::Device device;
+    cl::Program program;
+    std::string socketPath;
+    std::map<protocol::Operation, RegisteredKernel> kernels;
+    std::atomic<bool> stopping = false;
+
+    CoalescingConfig coalescing;
+    std::mutex pendingMutex;
+    std::condition_variable pendingArrived;
+    std::condition_variable pendingDone;
+    std::deque<PendingRequest *> pending;
+    bool coalescerStopping = false;
+    LatencyModel batchModel;    // Launch time by batch elements, to flush before deadlines pass
+    CoalescingStats stats;
+
+    std::mutex connectionsMutex;
+    std::condition_variable connectionsClosed;
+    std::set<int> connections;
+};
@@ -0,0 +1,180 @@
+#include "sparse.h"
+#include "host.h"
+#include "program.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <sstream>
+
+namespace {
+
+    const std::string KERNEL_PROGRAM_FILE = "kernel.cl";
+    const int REPEATS = 10;
+    // Densities run from 1 down to 2^-MAX_HALVINGS.
+    const int MAX_HALVINGS = 12;
+    const float SCALAR = 2.0f;
+    const float TOLERANCE = 1e-2;
+
+    template<typename Launch>
+    double bestSeconds(const cl::CommandQueue &queue, Launch launch) {
+        auto best = std::chrono::duration<double>::max();
+        for (int i = 0; i <= REPEATS; i++) {
+            auto start_time = std::chrono::high_resolution_clock::now();
+            launch();
+            queue.finish();
+            // The first round warms up the driver and is not counted.
+            if (i > 0) {
+                best = std::min<std::chrono::duration<double>>(best,
+                                                               std::chrono::high_resolution_clock::now() - start_time);
+            }
+        }
+        return best.count();
+    }
+
+    size_t roundUp(size_t value, size_t multiple) {
+        return (value + multiple - 1) / multiple * multiple;
+    }
+
+    // Compares the device's c with the host equivalent run over the same initial c.
+    bool matches(const cl::CommandQueue &queue, const cl::Buffer &cBuf, const std::vector<float> &expected) {
+        std::vector<float> c(expected.size());
+        queue.enqueueReadBuffer(cBuf, CL_TRUE, 0, sizeof(float) * c.size(), c.data());
+        for (size_t i = 0; i < c.size(); i++) {
+            if (!(std::fabs(c[i] - expected[i]) < TOLERANCE)) {
+                return false;
+            }
+        }
+        return true;
+    }
+}
+
+std::vector<uint32_t> randomIndices(size_t n, double density, unsigned seed) {
+    std::mt19937 generator(seed);
+    std::bernoulli_distribution listed(std::clamp(density, 0.0, 1.0));
+    std::vector<uint32_t> indices;
+    indices.reserve(static_cast<size_t>(density * n) + 1);
+    for (size_t i = 0; i < n; i++) {
+        if (listed(generator)) {
+            indices.push_back(static_cast<uint32_t>(i));
+        }
+    }
+    return indices;
+}
+
+std::vector<uint32_t> maskOf(const std::vector<uint32_t> &indices, size_t n) {
+    std::vector<uint32_t> mask((n + 31) / 32, 0);
+    for (uint32_t i: indices) {
+        mask[i / 32] |= 1u << i % 32;
+    }
+    return mask;
+}
+
+void printSparseReport(const std::vector<cl::Device> &devices, size_t elements) {
+    const size_t bytes = sizeof(float) * elements;
+    std::vector<float> x(elements), y(elements), initial(elements, -1.0f);
+    for (size_t i = 0; i < elements; i++) {
+        x[i] = static_cast<float>(i % 100);
+        y[i] = static_cast<float>(i % 7);
+    }
+    const size_t words = (elements + 31) / 32;
+
+    for (const auto &device: devices) {
+        cl::Context context(device);
+        cl::Program program = buildProgram(context, device, KERNEL_PROGRAM_FILE);
+        cl::CommandQueue queue(context, device);
+        cl::Buffer xBuf(context, CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR, bytes, x.data());
+        cl::Buffer yBuf(context, CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR, bytes, y.data());
+        cl::Buffer cBuf(context, CL_MEM_READ_WRITE, bytes);
+        // Sized for every element, so each density reuses them.
+        cl::Buffer indexBuf(context, CL_MEM_READ_ONLY, sizeof(uint32_t) * elements);
+        cl::Buffer maskBuf(context, CL_MEM_READ_ONLY, sizeof(uint32_t) * words);
+
+        cl::Kernel dense(program, "vadd"), indexed(program, "vadd_indexed"), masked(program, "vadd_masked");
+        for (cl::Kernel *kernel: {&dense, &indexed, &masked}) {
+            kernel->setArg(0, SCALAR);
+            kernel->setArg(1, xBuf);
+            kernel->setArg(2, yBuf);
+            kernel->setArg(3, cBuf);
+        }
+        indexed.setArg(4, indexBuf);
+        masked.setArg(4, maskBuf);
+        masked.setArg(5, static_cast<cl_uint>(words));
+        const size_t wave = indexed.getWorkGroupInfo<CL_KERNEL_PREFERRED_WORK_GROUP_SIZE_MULTIPLE>(device);
+
+        const double denseSeconds = bestSeconds(queue, [&] {
+            queue.enqueueNDRangeKernel(dense, cl::NullRange, cl::NDRange(elements));
+        });
+
+        std::cout << "Sparse vadd on " << device.getInfo<CL_DEVICE_NAME>() << " over " << elements
+                  << " elements, dense vadd takes " << std::fixed << std::setprecision(1) << denseSeconds * 1e6
+                  << " us (us per call, uploads of indices or mask included):\n"
+                  << std::setw(12) << "density" << std::setw(12) << "indexed" << std::setw(12) << "masked" << "\n";
+        double indexedCrossover = 0, maskedCrossover = 0;
+        for (int halvings = 0; halvings <= MAX_HALVINGS; halvings++) {
+            const double density = std::ldexp(1.0, -halvings);
+            const auto indices = randomIndices(elements, density, static_cast<unsigned>(halvings));
+            const auto mask = maskOf(indices, elements);
+            const cl_uint count = static_cast<cl_uint>(indices.size());
+            indexed.setArg(5, count);
+
+            auto launchIndexed = [&] {
+                if (count > 0) {
+                    queue.enqueueNDRangeKernel(indexed, cl::NullRange, cl::NDRange(roundUp(count, wave)));
+                }
+            };
+            auto launchMasked = [&] {
+                queue.enqueueNDRangeKernel(masked, cl::NullRange, cl::NDRange(roundUp(words, wave)));
+            };
+            const double indexedSeconds = bestSeconds(queue, [&] {
+                if (count > 0) {
+                    queue.enqueueWriteBuffer(indexBuf, CL_FALSE, 0, sizeof(uint32_t) * count, indices.data());
+                }
+                launchIndexed();
+            });
+            const double maskedSeconds = bestSeconds(queue, [&] {
+                queue.enqueueWriteBuffer(maskBuf, CL_FALSE, 0, sizeof(uint32_t) * words, mask.data());
+                launchMasked();
+            });
+
+            // Both only touch listed elements, so a c starting from known values tells if they touched others.
+            std::vector<float> expected = initial;
+            vaddOnHostMasked(SCALAR, x.data(), y.data(), expected.data(), mask.data(), elements);
+            auto check = [&](const std::string &name, const std::function<void()> &launch) {
+                queue.enqueueWriteBuffer(cBuf, CL_TRUE, 0, bytes, initial.data());
+                launch();
+                if (!matches(queue, cBuf, expected)) {
+                    std::cerr << name << " differs from the host at density " << density << std::endl;
+                    std::exit(1);
+                }
+            };
+            check("vadd_indexed", launchIndexed);
+            check("vadd_masked", launchMasked);
+
+            if (indexedCrossover == 0 && indexedSeconds < denseSeconds) {
+                indexedCrossover = density;
+            }
+            if (maskedCrossover == 0 && maskedSeconds < denseSeconds) {
+                maskedCrossover = density;
+            }
+            std::cout << std::setw(11) << std::setprecision(3) << density * 100 << "%" << std::setprecision(1)
+                      << std::setw(12) << indexedSeconds * 1e6 << std::setw(12) << maskedSeconds * 1e6 << "\n";
+        }
+        auto crossover = [](double density) {
+            std::ostringstream text;
+            text << std::setprecision(3);
+            if (density > 0) {
+                text << "at " << density * 100 << "% density and below";
+            } else {
+                text << "at no density measured";
+            }
+            return text.str();
+        };
+        std::cout << "vadd_indexed beats dense vadd " << crossover(indexedCrossover) << ", vadd_masked "
+                  << crossover(maskedCrossover) << std::endl;
+    }
+}
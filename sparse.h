@@ -0,0 +1,19 @@
+#pragma once
+
+#include <CL/opencl.hpp>
+#include <cstdint>
+#include <vector>
+
+// About density * n distinct indices of [0, n), ascending, picked at random.
+std::vector<uint32_t> randomIndices(size_t n, double density, unsigned seed);
+
+// The mask of vadd_masked with the bits of indices set, (n + 31) / 32 words.
+std::vector<uint32_t> maskOf(const std::vector<uint32_t> &indices, size_t n);
+
+/**
+ * Times vadd_indexed and vadd_masked on each device against the dense vadd over `elements`
+ * floats resident on the device, halving the share of elements to update from all down to
+ * 1/4096. Sparse timings include uploading the index list or mask, which change per call.
+ * Prints them with the highest density where each sparse kernel beats the dense one.
+ **/
+void printSparseReport(const std::vector<cl::Device> &devices, size_t elements);
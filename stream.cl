@@ -0,0 +1,29 @@
+/**
+ * STREAM style kernels measuring the sustainable memory bandwidth of a device.
+ * Every operation is instantiated for float, float2, float4, float8 and float16
+ * as <operation>_<width>, e.g. triad_4.
+ **/
+
+#define STREAM_KERNELS(T, W)                                                                          \
+ __kernel void copy_##W(__global const T* a, __global T* c){                                          \
+     const size_t index = get_global_id(0);                                                           \
+     c[index] = a[index];                                                                             \
+ }                                                                                                    \
+ __kernel void scale_##W(__global const T* a, __global T* c, float q){                                \
+     const size_t index = get_global_id(0);                                                           \
+     c[index] = q * a[index];                                                                         \
+ }                                                                                                    \
+ __kernel void add_##W(__global const T* a, __global const T* b, __global T* c){                      \
+     const size_t index = get_global_id(0);                                                           \
+     c[index] = a[index] + b[index];                                                                  \
+ }                                                                                                    \
+ __kernel void triad_##W(__global const T* a, __global const T* b, __global T* c, float q){           \
+     const size_t index = get_global_id(0);                                                           \
+     c[index] = a[index] + q * b[index];                                                              \
+ }
+
+STREAM_KERNELS(float, 1)
+STREAM_KERNELS(float2, 2)
+STREAM_KERNELS(float4, 4)
+STREAM_KERNELS(float8, 8)
+STREAM_KERNELS(float16, 16)
@@ -0,0 +1,95 @@
+#include "svm.h"
+
+#include <cstdio>
+
+std::string svmModeName(SvmMode mode) {
+    return mode == SvmMode::FineGrain ? "fine-grained SVM" : "coarse-grained SVM";
+}
+
+#if CL_HPP_TARGET_OPENCL_VERSION >= 200
+
+std::vector<SvmMode> supportedSvmModes(const cl::Device &device) {
+    // CL_DEVICE_VERSION reads "OpenCL <major>.<minor> <vendor specific>".
+    int major = 0, minor = 0;
+    if (std::sscanf(device.getInfo<CL_DEVICE_VERSION>().c_str(), "OpenCL %d.%d", &major, &minor) != 2 ||
+        major < 2) {
+        return {};
+    }
+    const auto capabilities = device.getInfo<CL_DEVICE_SVM_CAPABILITIES>();
+    std::vector<SvmMode> modes;
+    if (capabilities & CL_DEVICE_SVM_COARSE_GRAIN_BUFFER) {
+        modes.push_back(SvmMode::CoarseGrain);
+    }
+    if (capabilities & CL_DEVICE_SVM_FINE_GRAIN_BUFFER) {
+        modes.push_back(SvmMode::FineGrain);
+    }
+    return modes;
+}
+
+SvmArray::SvmArray(const cl::Context &context, size_t size, SvmMode mode)
+        : context(context), elements(size), mode(mode) {
+    cl_svm_mem_flags flags = CL_MEM_READ_WRITE;
+    if (mode == SvmMode::FineGrain) {
+        flags |= CL_MEM_SVM_FINE_GRAIN_BUFFER;
+    }
+    pointer = static_cast<float *>(clSVMAlloc(context(), flags, sizeof(float) * size, 0));
+}
+
+SvmArray::~SvmArray() {
+    if (pointer != nullptr) {
+        clSVMFree(context(), pointer);
+    }
+}
+
+cl_int SvmArray::map(const cl::CommandQueue &queue, cl_map_flags flags) const {
+    if (mode == SvmMode::FineGrain) {
+        return CL_SUCCESS;
+    }
+    return clEnqueueSVMMap(queue(), CL_TRUE, flags, pointer, sizeof(float) * elements, 0, nullptr, nullptr);
+}
+
+cl_int SvmArray::unmap(const cl::CommandQueue &queue) const {
+    if (mode == SvmMode::FineGrain) {
+        return CL_SUCCESS;
+    }
+    return clEnqueueSVMUnmap(queue(), pointer, 0, nullptr, nullptr);
+}
+
+cl_int SvmArray::setAsArg(const cl::Kernel &kernel, cl_uint index) const {
+    return clSetKernelArgSVMPointer(kernel(), index, pointer);
+}
+
+#else
+
+std::vector<SvmMode> supportedSvmModes(const cl::Device &) {
+    return {};
+}
+
+// Never constructed, supportedSvmModes offers no mode in OpenCL 1.2 builds.
+SvmArray::SvmArray(const cl::Context &context, size_t size, SvmMode mode)
+        : context(context), elements(size), mode(mode) {
+}
+
+SvmArray::~SvmArray() = default;
+
+cl_int SvmArray::map(const cl::CommandQueue &, cl_map_flags) const {
+    return CL_INVALID_OPERATION;
+}
+
+cl_int SvmArray::unmap(const cl::CommandQueue &) const {
+    return CL_INVALID_OPERATION;
+}
+
+cl_int SvmArray::setAsArg(const cl::Kernel &, cl_uint) const {
+    return CL_INVALID_OPERATION;
+}
+
+#endif
+
+float *SvmArray::data() const {
+    return pointer;
+}
+
+size_t SvmArray::size() const {
+    return elements;
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <CL/opencl.hpp>
+#include <string>
+#include <vector>
+
+enum class SvmMode {
+    CoarseGrain,    // shared buffer, the host maps it around its accesses
+    FineGrain       // shared buffer the host and device access without maps
+};
+
+std::string svmModeName(SvmMode mode);
+
+/**
+ * SVM modes the device supports. Always empty when built for OpenCL 1.2, see the OPENCL_SVM
+ * CMake option, and for devices below OpenCL 2.0 or without SVM, which use buffers instead.
+ **/
+std::vector<SvmMode> supportedSvmModes(const cl::Device &device);
+
+/**
+ * Floats allocated with clSVMAlloc, passed to kernels with clSetKernelArgSVMPointer. Coarse
+ * grained arrays must be mapped before the host touches them and unmapped before kernels do.
+ **/
+class SvmArray {
+public:
+    SvmArray(const cl::Context &context, size_t size, SvmMode mode);
+
+    ~SvmArray();
+
+    SvmArray(const SvmArray &) = delete;
+
+    SvmArray &operator=(const SvmArray &) = delete;
+
+    float *data() const;
+
+    size_t size() const;
+
+    // Makes the contents accessible to the host, a no-op for fine grained arrays.
+    cl_int map(const cl::CommandQueue &queue, cl_map_flags flags) const;
+
+    // Hands the contents back to the device, a no-op for fine grained arrays.
+    cl_int unmap(const cl::CommandQueue &queue) const;
+
+    cl_int setAsArg(const cl::Kernel &kernel, cl_uint index) const;
+
+private:
+    cl::Context context;
+    float *pointer = nullptr;
+    size_t elements;
+    SvmMode mode;
+};
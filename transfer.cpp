@@ -0,0 +1,233 @@
+#include "transfer.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+
+namespace {
+
+    const int REPEATS = 10;
+    const size_t MIN_TRANSFER_BYTES = 4096;
+    const TransferStrategy STRATEGIES[] = {TransferStrategy::Pageable, TransferStrategy::PinnedStaging,
+                                           TransferStrategy::CopyHostPtr, TransferStrategy::UseHostPtr,
+                                           TransferStrategy::MapUnmap};
+
+    // Best time of `repeats` runs of transfer, each preceded by an untimed prepare.
+    double bestSeconds(int repeats, const std::function<void()> &prepare, const std::function<void()> &transfer) {
+        auto best = std::chrono::duration<double>::max();
+        for (int i = 0; i < repeats; i++) {
+            prepare();
+            auto start_time = std::chrono::high_resolution_clock::now();
+            transfer();
+            best = std::min<std::chrono::duration<double>>(best, std::chrono::high_resolution_clock::now() - start_time);
+        }
+        return best.count();
+    }
+
+    // Buffers created from host memory may stay on the host until first use, so move them explicitly.
+    void migrateToDevice(const cl::CommandQueue &queue, const cl::Buffer &buffer) {
+        queue.enqueueMigrateMemObjects({buffer}, 0);
+        queue.finish();
+    }
+
+    double toGbPerSecond(const TransferResult &result) {
+        return static_cast<double>(result.bytes) / result.seconds * 1e-9;
+    }
+}
+
+std::string strategyName(TransferStrategy strategy) {
+    switch (strategy) {
+        case TransferStrategy::Pageable:
+            return "pageable";
+        case TransferStrategy::PinnedStaging:
+            return "pinned staging";
+        case TransferStrategy::CopyHostPtr:
+            return "COPY_HOST_PTR";
+        case TransferStrategy::UseHostPtr:
+            return "USE_HOST_PTR";
+        case TransferStrategy::MapUnmap:
+            return "map/unmap";
+    }
+    return "";
+}
+
+bool isApplicable(TransferStrategy strategy, TransferDirection direction, bool blocking) {
+    switch (strategy) {
+        case TransferStrategy::CopyHostPtr:
+            return direction == TransferDirection::HostToDevice && blocking;
+        case TransferStrategy::UseHostPtr:
+            return direction == TransferDirection::DeviceToHost || blocking;
+        default:
+            return true;
+    }
+}
+
+double measureTransfer(const cl::Context &context, const cl::CommandQueue &queue, TransferStrategy strategy,
+                       TransferDirection direction, bool blocking, void *host, size_t bytes, int repeats) {
+    const cl_bool block = blocking ? CL_TRUE : CL_FALSE;
+    const bool toDevice = direction == TransferDirection::HostToDevice;
+    cl::Buffer deviceBuf(context, CL_MEM_READ_WRITE, bytes);
+
+    auto nothing = [] {};
+    // Leaves freshly written data on the device, so the following read has to move it.
+    auto writeOnDevice = [&](const cl::Buffer &buffer) {
+        return [&] {
+            queue.enqueueFillBuffer(buffer, 0.0f, 0, bytes);
+            queue.finish();
+        };
+    };
+    auto synchronize = [&] {
+        if (!blocking) {
+            queue.finish();
+        }
+    };
+
+    switch (strategy) {
+        case TransferStrategy::Pageable:
+            if (toDevice) {
+                return bestSeconds(repeats, nothing, [&] {
+                    queue.enqueueWriteBuffer(deviceBuf, block, 0, bytes, host);
+                    synchronize();
+                });
+            }
+            return bestSeconds(repeats, writeOnDevice(deviceBuf), [&] {
+                queue.enqueueReadBuffer(deviceBuf, block, 0, bytes, host);
+                synchronize();
+            });
+
+        case TransferStrategy::PinnedStaging: {
+            // Applications fill the staging buffer directly, so only its copy to the device is timed.
+            cl::Buffer pinnedBuf(context, CL_MEM_ALLOC_HOST_PTR, bytes);
+            void *staging = queue.enqueueMapBuffer(pinnedBuf, CL_TRUE, CL_MAP_READ | CL_MAP_WRITE, 0, bytes);
+            double seconds;
+            if (toDevice) {
+                seconds = bestSeconds(repeats, nothing, [&] {
+                    queue.enqueueWriteBuffer(deviceBuf, block, 0, bytes, staging);
+                    synchronize();
+                });
+            } else {
+                seconds = bestSeconds(repeats, writeOnDevice(deviceBuf), [&] {
+                    queue.enqueueReadBuffer(deviceBuf, block, 0, bytes, staging);
+                    synchronize();
+                });
+            }
+            queue.enqueueUnmapMemObject(pinnedBuf, staging);
+            queue.finish();
+            return seconds;
+        }
+
+        case TransferStrategy::CopyHostPtr:
+            return bestSeconds(repeats, nothing, [&] {
+                cl::Buffer buffer(context, CL_MEM_READ_WRITE | CL_MEM_COPY_HOST_PTR, bytes, host);
+                migrateToDevice(queue, buffer);
+            });
+
+        case TransferStrategy::UseHostPtr: {
+            if (toDevice) {
+                return bestSeconds(repeats, nothing, [&] {
+                    cl::Buffer buffer(context, CL_MEM_READ_WRITE | CL_MEM_USE_HOST_PTR, bytes, host);
+                    migrateToDevice(queue, buffer);
+                });
+            }
+            cl::Buffer wrappedBuf(context, CL_MEM_READ_WRITE | CL_MEM_USE_HOST_PTR, bytes, host);
+            return bestSeconds(repeats, writeOnDevice(wrappedBuf), [&] {
+                cl::Event mapped;
+                void *data = queue.enqueueMapBuffer(wrappedBuf, block, CL_MAP_READ, 0, bytes, nullptr, &mapped);
+                mapped.wait();
+                queue.enqueueUnmapMemObject(wrappedBuf, data);
+                queue.finish();
+            });
+        }
+
+        case TransferStrategy::MapUnmap:
+            return bestSeconds(repeats, toDevice ? std::function<void()>(nothing) : writeOnDevice(deviceBuf), [&] {
+                cl::Event mapped;
+                void *data = queue.enqueueMapBuffer(deviceBuf, block,
+                                                    toDevice ? CL_MAP_WRITE_INVALIDATE_REGION : CL_MAP_READ,
+                                                    0, bytes, nullptr, &mapped);
+                mapped.wait();
+                if (toDevice) {
+                    std::memcpy(data, host, bytes);
+                } else {
+                    std::memcpy(host, data, bytes);
+                }
+                queue.enqueueUnmapMemObject(deviceBuf, data);
+                queue.finish();
+            });
+    }
+    return 0;
+}
+
+std::vector<TransferResult> measureTransfers(const cl::Context &context, const cl::Device &device,
+                                             const std::vector<size_t> &sizes) {
+    cl::CommandQueue queue(context, device);
+    std::vector<float> host(*std::max_element(sizes.begin(), sizes.end()) / sizeof(float), 1.0f);
+
+    std::vector<TransferResult> results;
+    for (auto strategy: STRATEGIES) {
+        for (auto direction: {TransferDirection::HostToDevice, TransferDirection::DeviceToHost}) {
+            for (bool blocking: {true, false}) {
+                if (!isApplicable(strategy, direction, blocking)) {
+                    continue;
+                }
+                for (size_t bytes: sizes) {
+                    double seconds = measureTransfer(context, queue, strategy, direction, blocking, host.data(), bytes,
+                                                     REPEATS);
+                    results.push_back({strategy, direction, blocking, bytes, seconds});
+                }
+            }
+        }
+    }
+    return results;
+}
+
+void printTransferReport(const std::vector<cl::Device> &devices, size_t maxBytes) {
+    std::vector<size_t> sizes;
+    for (size_t bytes = MIN_TRANSFER_BYTES; bytes < maxBytes; bytes *= 16) {
+        sizes.push_back(bytes);
+    }
+    sizes.push_back(maxBytes);
+
+    for (const auto &device: devices) {
+        cl::Context context(device);
+        auto results = measureTransfers(context, device, sizes);
+
+        std::cout << "Host-device transfers on " << device.getInfo<CL_DEVICE_NAME>()
+                  << " (GB/s per transfer size in bytes, latency of the smallest in us):\n"
+                  << std::left << std::setw(34) << "  strategy" << std::right;
+        for (size_t bytes: sizes) {
+            std::cout << std::setw(11) << bytes;
+        }
+        std::cout << std::setw(11) << "latency" << "\n" << std::fixed << std::setprecision(2);
+
+        // Results come grouped by strategy, direction and mode with one entry per size.
+        for (size_t row = 0; row < results.size(); row += sizes.size()) {
+            const auto &first = results[row];
+            std::string label = strategyName(first.strategy) +
+                                (first.direction == TransferDirection::HostToDevice ? " H2D" : " D2H") +
+                                (first.blocking ? " blocking" : " async");
+            std::cout << "  " << std::left << std::setw(32) << label << std::right;
+            for (size_t i = 0; i < sizes.size(); i++) {
+                std::cout << std::setw(11) << toGbPerSecond(results[row + i]);
+            }
+            std::cout << std::setw(11) << first.seconds * 1e6 << "\n";
+        }
+
+        for (auto direction: {TransferDirection::HostToDevice, TransferDirection::DeviceToHost}) {
+            const TransferResult *best = nullptr;
+            for (const auto &result: results) {
+                if (result.direction == direction && result.bytes == maxBytes &&
+                    (best == nullptr || result.seconds < best->seconds)) {
+                    best = &result;
+                }
+            }
+            std::cout << "  Recommended " << (direction == TransferDirection::HostToDevice ? "host to device: "
+                                                                                          : "device to host: ")
+                      << strategyName(best->strategy) << (best->blocking ? " (blocking)" : " (async)") << "\n";
+        }
+        std::cout << std::flush;
+    }
+}
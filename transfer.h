@@ -0,0 +1,46 @@
+#pragma once
+
+#include <CL/opencl.hpp>
+#include <string>
+#include <vector>
+
+// How data gets between a host vector and device memory.
+enum class TransferStrategy {
+    Pageable,       // enqueueWrite/ReadBuffer straight from a std::vector
+    PinnedStaging,  // enqueueWrite/ReadBuffer from a mapped CL_MEM_ALLOC_HOST_PTR buffer
+    CopyHostPtr,    // CL_MEM_COPY_HOST_PTR buffer created from the vector, host to device only
+    UseHostPtr,     // CL_MEM_USE_HOST_PTR buffer wrapping the vector
+    MapUnmap        // map the device buffer and memcpy to or from the vector
+};
+
+enum class TransferDirection {
+    HostToDevice,
+    DeviceToHost
+};
+
+struct TransferResult {
+    TransferStrategy strategy;
+    TransferDirection direction;
+    bool blocking;
+    size_t bytes;
+    double seconds;     // Best of several transfers, including synchronisation
+};
+
+std::string strategyName(TransferStrategy strategy);
+
+// Creation flags already copy the data, so blocking only matters for explicit transfers and maps.
+bool isApplicable(TransferStrategy strategy, TransferDirection direction, bool blocking);
+
+// Best time of `repeats` transfers of bytes between host and a fresh device buffer, including synchronisation.
+double measureTransfer(const cl::Context &context, const cl::CommandQueue &queue, TransferStrategy strategy,
+                       TransferDirection direction, bool blocking, void *host, size_t bytes, int repeats);
+
+// Times every applicable strategy, direction and blocking mode for each size in bytes.
+std::vector<TransferResult> measureTransfers(const cl::Context &context, const cl::Device &device,
+                                             const std::vector<size_t> &sizes);
+
+/**
+ * Prints bandwidth and small-transfer latency of every strategy for each device, followed by
+ * the fastest strategy per direction for transfers of maxBytes.
+ **/
+void printTransferReport(const std::vector<cl::Device> &devices, size_t maxBytes);